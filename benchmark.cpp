@@ -0,0 +1,622 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <execution>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "benchmark.h"
+#include "instrumentation.h"
+#include "near_duplicates.h"
+#include "paginator.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "string_processing.h"
+#include "versioned_search_server.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Результаты операций складываются сюда, чтобы компилятор не выбросил замеряемый код
+size_t benchmark_sink = 0;
+
+// Различные слова: ранг записывается по основанию 26 и дополняется случайными буквами
+std::vector<std::string> GenerateVocabulary(std::mt19937& generator, size_t size) {
+    std::vector<std::string> vocabulary;
+    vocabulary.reserve(size);
+    for (size_t rank = 0; rank < size; ++rank) {
+        std::string word;
+        for (size_t n = rank; ; n /= 26) {
+            word.push_back('a' + n % 26);
+            if (n < 26) {
+                break;
+            }
+        }
+        const int padding = std::uniform_int_distribution(0, 4)(generator);
+        word.push_back('_');
+        for (int i = 0; i < padding; ++i) {
+            word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+        }
+        vocabulary.push_back(std::move(word));
+    }
+    return vocabulary;
+}
+
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t size, double exponent)
+        : cumulative_(size)
+    {
+        double sum = 0;
+        for (size_t rank = 0; rank < size; ++rank) {
+            sum += 1.0 / std::pow(rank + 1.0, exponent);
+            cumulative_[rank] = sum;
+        }
+    }
+
+    size_t operator()(std::mt19937& generator) const {
+        const double value = std::uniform_real_distribution<>(0, cumulative_.back())(generator);
+        const auto it = std::lower_bound(cumulative_.begin(), cumulative_.end(), value);
+        return std::min<size_t>(it - cumulative_.begin(), cumulative_.size() - 1);
+    }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+DocumentStatus GenerateStatus(std::mt19937& generator, const CorpusOptions& options) {
+    const double value = std::uniform_real_distribution<>(0, 1)(generator);
+    if (value < options.irrelevant_share) {
+        return DocumentStatus::IRRELEVANT;
+    }
+    if (value < options.irrelevant_share + options.banned_share) {
+        return DocumentStatus::BANNED;
+    }
+    if (value < options.irrelevant_share + options.banned_share + options.removed_share) {
+        return DocumentStatus::REMOVED;
+    }
+    return DocumentStatus::ACTUAL;
+}
+
+uint64_t GetPercentile(const std::vector<uint64_t>& sorted_samples, double percentile) {
+    if (sorted_samples.empty()) {
+        return 0;
+    }
+    const size_t index = static_cast<size_t>(percentile * (sorted_samples.size() - 1) + 0.5);
+    return sorted_samples[index];
+}
+
+}
+
+Corpus GenerateCorpus(const CorpusOptions& options) {
+    std::mt19937 generator(options.seed);
+    Corpus corpus;
+    corpus.vocabulary = GenerateVocabulary(generator, std::max<size_t>(options.vocabulary_size, 1));
+    // самые частые слова - стоп-слова, как в настоящих текстах
+    corpus.stop_words.assign(corpus.vocabulary.begin(),
+                             corpus.vocabulary.begin() + std::min<size_t>(3, corpus.vocabulary.size() - 1));
+
+    const ZipfDistribution word_distribution(corpus.vocabulary.size(), options.zipf_exponent);
+    const auto generate_text = [&](size_t length) {
+        std::string text;
+        for (size_t i = 0; i < length; ++i) {
+            if (i > 0) {
+                text.push_back(' ');
+            }
+            text += corpus.vocabulary[word_distribution(generator)];
+        }
+        return text;
+    };
+
+    corpus.documents.reserve(options.document_count);
+    for (size_t i = 0; i < options.document_count; ++i) {
+        DocumentRecord record;
+        record.id = static_cast<int>(i);
+        if (i > 0 && std::uniform_real_distribution<>(0, 1)(generator) < options.duplicate_share) {
+            // тот же набор слов в другом порядке
+            auto words = SplitIntoWords(corpus.documents[generator() % i].text);
+            std::shuffle(words.begin(), words.end(), generator);
+            for (const std::string_view word : words) {
+                record.text += word;
+                record.text.push_back(' ');
+            }
+        } else {
+            const size_t length = std::uniform_int_distribution<size_t>(
+                options.min_document_length, std::max(options.min_document_length, options.max_document_length))(generator);
+            record.text = generate_text(length);
+        }
+        record.status = GenerateStatus(generator, options);
+        for (size_t j = 0; j < options.ratings_per_document; ++j) {
+            record.ratings.push_back(std::uniform_int_distribution(options.min_rating, options.max_rating)(generator));
+        }
+        corpus.documents.push_back(std::move(record));
+    }
+
+    corpus.queries.reserve(options.query_count);
+    for (size_t i = 0; i < options.query_count; ++i) {
+        std::string query;
+        for (size_t j = 0; j < options.query_length; ++j) {
+            if (j > 0) {
+                query.push_back(' ');
+            }
+            if (std::uniform_real_distribution<>(0, 1)(generator) < options.minus_word_probability) {
+                query.push_back('-');
+            }
+            query += corpus.vocabulary[word_distribution(generator)];
+        }
+        corpus.queries.push_back(std::move(query));
+    }
+    return corpus;
+}
+
+uint64_t GetPeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss);
+}
+
+uint64_t GetPostingsScanned() {
+    uint64_t postings_scanned = 0;
+    for (const auto& counter : StatsRegistry::Instance().Collect().counters) {
+        if (counter.name == "postings_scanned"s) {
+            postings_scanned += counter.value;
+        }
+    }
+    return postings_scanned;
+}
+
+    BenchmarkRunner::BenchmarkRunner(std::ostream* progress)
+        : progress_(progress)
+    {
+    }
+
+    const std::vector<BenchmarkResult>& BenchmarkRunner::GetResults() const {
+        return results_;
+    }
+
+    const BenchmarkResult& BenchmarkRunner::AddResult(const std::string& name, std::vector<uint64_t> samples,
+                                                      double total_seconds) {
+        std::sort(samples.begin(), samples.end());
+        BenchmarkResult result;
+        result.name = name;
+        result.operation_count = samples.size();
+        result.total_seconds = total_seconds;
+        if (!samples.empty()) {
+            result.ns_per_operation = total_seconds * 1e9 / samples.size();
+            result.operations_per_second = total_seconds > 0 ? samples.size() / total_seconds : 0;
+            result.max_ns = samples.back();
+        }
+        result.p50_ns = GetPercentile(samples, 0.5);
+        result.p90_ns = GetPercentile(samples, 0.9);
+        result.p99_ns = GetPercentile(samples, 0.99);
+        result.peak_rss_kb = GetPeakRssKb();
+        results_.push_back(std::move(result));
+        if (progress_ != nullptr) {
+            *progress_ << results_.back().name << ": "s << results_.back().ns_per_operation << " ns/op"s << std::endl;
+        }
+        return results_.back();
+    }
+
+void PrintBenchmarkReport(std::ostream& out, const CorpusOptions& options,
+                          const std::vector<BenchmarkResult>& results, ReportFormat format) {
+    if (format == ReportFormat::TEXT) {
+        out << "corpus: "s << options.document_count << " documents, vocabulary "s << options.vocabulary_size
+            << ", zipf "s << options.zipf_exponent << ", seed "s << options.seed << '\n';
+        out << std::left << std::setw(40) << "benchmark"s << std::right
+            << std::setw(10) << "ops"s << std::setw(14) << "ns/op"s << std::setw(14) << "ops/s"s
+            << std::setw(12) << "p50 ns"s << std::setw(12) << "p90 ns"s << std::setw(12) << "p99 ns"s
+            << std::setw(14) << "max ns"s << std::setw(14) << "peak RSS KB"s << std::setw(10) << "GB/s"s
+            << std::setw(10) << "skipped"s << '\n';
+        for (const auto& result : results) {
+            out << std::left << std::setw(40) << result.name << std::right
+                << std::setw(10) << result.operation_count
+                << std::setw(14) << std::fixed << std::setprecision(1) << result.ns_per_operation
+                << std::setw(14) << result.operations_per_second << std::defaultfloat
+                << std::setw(12) << result.p50_ns << std::setw(12) << result.p90_ns << std::setw(12) << result.p99_ns
+                << std::setw(14) << result.max_ns << std::setw(14) << result.peak_rss_kb
+                << std::setw(10) << std::fixed << std::setprecision(3) << result.gigabytes_per_second
+                << std::setw(10) << result.postings_skipped_fraction << std::defaultfloat << '\n';
+        }
+        return;
+    }
+
+    out << "{\"corpus\": {\"documents\": "s << options.document_count
+        << ", \"vocabulary\": "s << options.vocabulary_size
+        << ", \"zipf_exponent\": "s << options.zipf_exponent
+        << ", \"min_document_length\": "s << options.min_document_length
+        << ", \"max_document_length\": "s << options.max_document_length
+        << ", \"queries\": "s << options.query_count
+        << ", \"query_length\": "s << options.query_length
+        << ", \"seed\": "s << options.seed << "},\n\"results\": [\n"s;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        out << "  {\"name\": \""s << result.name << "\", \"operations\": "s << result.operation_count
+            << ", \"total_seconds\": "s << result.total_seconds
+            << ", \"ns_per_op\": "s << result.ns_per_operation
+            << ", \"ops_per_second\": "s << result.operations_per_second
+            << ", \"p50_ns\": "s << result.p50_ns << ", \"p90_ns\": "s << result.p90_ns
+            << ", \"p99_ns\": "s << result.p99_ns << ", \"max_ns\": "s << result.max_ns
+            << ", \"peak_rss_kb\": "s << result.peak_rss_kb
+            << ", \"gb_per_second\": "s << result.gigabytes_per_second
+            << ", \"postings_skipped_fraction\": "s << result.postings_skipped_fraction << '}' << (i + 1 < results.size() ? ",\n"s : "\n"s);
+    }
+    out << "]}\n"s;
+}
+
+std::vector<BenchmarkResult> RunSearchServerBenchmarks(const CorpusOptions& options, std::ostream* progress) {
+    const Corpus corpus = GenerateCorpus(options);
+    const auto& documents = corpus.documents;
+    const auto& queries = corpus.queries;
+    BenchmarkRunner runner(progress);
+
+    {
+        size_t corpus_bytes = 0;
+        for (const auto& document : documents) {
+            corpus_bytes += document.text.size();
+        }
+        // прежняя реализация: поиск пробелов через find и отдельная побайтовая проверка каждого слова
+        runner.RunThroughput("SplitIntoWords/baseline"s, 1, corpus_bytes, [&](size_t) {
+            for (const auto& document : documents) {
+                const std::string_view text = document.text;
+                std::vector<std::string_view> words;
+                for (size_t word_begin = 0; word_begin < text.size();) {
+                    const size_t space = text.find(' ', word_begin);
+                    const size_t word_end = space == std::string_view::npos ? text.size() : space;
+                    if (word_end != word_begin) {
+                        words.push_back(text.substr(word_begin, word_end - word_begin));
+                    }
+                    word_begin = word_end + 1;
+                }
+                for (const std::string_view word : words) {
+                    benchmark_sink += std::none_of(word.begin(), word.end(), [](char c) {
+                        return c >= '\0' && c < ' ';
+                    });
+                }
+            }
+        });
+        runner.RunThroughput("SplitIntoWords/scalar"s, 1, corpus_bytes, [&](size_t) {
+            for (const auto& document : documents) {
+                benchmark_sink += SplitIntoCheckedWordsScalar(document.text).words.size();
+            }
+        });
+        runner.RunThroughput("SplitIntoWords/"s + std::string(GetTokenizerImplementation()), 1, corpus_bytes, [&](size_t) {
+            for (const auto& document : documents) {
+                benchmark_sink += SplitIntoCheckedWords(document.text).words.size();
+            }
+        });
+    }
+
+    SearchServer search_server(corpus.stop_words);
+    runner.Run("AddDocument"s, documents.size(), [&](size_t i) {
+        const auto& document = documents[i];
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    });
+    {
+        SearchServer bulk_server(corpus.stop_words);
+        auto records = documents;
+        runner.Run("AddDocuments"s, 1, [&](size_t) {
+            bulk_server.AddDocuments(std::move(records));
+        });
+        benchmark_sink += bulk_server.GetDocumentCount();
+    }
+
+    const auto run_queries = [&](const std::string& name, auto find) {
+        runner.Run(name, queries.size(), [&](size_t i) {
+            benchmark_sink += find(queries[i]).size();
+        });
+    };
+    // отсечение WAND сравнивается с полным перебором тех же запросов по числу просмотренных документов
+    const uint64_t postings_scanned_before = GetPostingsScanned();
+    run_queries("FindTopDocuments/seq/ACTUAL"s, [&](const std::string& query) {
+        return search_server.FindTopDocuments(std::execution::seq, query);
+    });
+    const uint64_t exhaustive_scanned = GetPostingsScanned() - postings_scanned_before;
+    run_queries("FindTopDocuments/par/ACTUAL"s, [&](const std::string& query) {
+        return search_server.FindTopDocuments(std::execution::par, query);
+    });
+    {
+        SearchOptions wand_options;
+        wand_options.algorithm = TopDocumentsAlgorithm::WAND;
+        runner.RunPruned("FindTopDocuments/seq/wand"s, queries.size(), exhaustive_scanned, [&](size_t i) {
+            benchmark_sink += search_server.FindTopDocuments(std::execution::seq, queries[i], wand_options).size();
+        });
+        runner.RunPruned("FindTopDocuments/par/wand"s, queries.size(), exhaustive_scanned, [&](size_t i) {
+            benchmark_sink += search_server.FindTopDocuments(std::execution::par, queries[i], wand_options).size();
+        });
+    }
+    run_queries("FindTopDocuments/seq/BANNED"s, [&](const std::string& query) {
+        return search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::BANNED);
+    });
+    // тот же фильтр, что у seq/ACTUAL, но произвольным предикатом, без быстрого пути по столбцу статусов
+    run_queries("FindTopDocuments/seq/status-predicate"s, [&](const std::string& query) {
+        return search_server.FindTopDocuments(std::execution::seq, query,
+            [](int, DocumentStatus status, int) {
+                return status == DocumentStatus::ACTUAL;
+            });
+    });
+    run_queries("FindTopDocuments/seq/predicate"s, [&](const std::string& query) {
+        return search_server.FindTopDocuments(std::execution::seq, query,
+            [](int document_id, DocumentStatus, int rating) {
+                return document_id % 2 == 0 && rating > 0;
+            });
+    });
+    run_queries("FindTopDocuments/seq/page3"s, [&](const std::string& query) {
+        return search_server.FindTopDocuments(query, {10, 20});
+    });
+    if (corpus.vocabulary.size() > 2 * corpus.stop_words.size() + 4) {
+        // самые частые после стоп-слов слова корпуса в роли минус-слов при редком плюс-слове,
+        // как в "-spam -ads laptop"
+        const auto& vocabulary = corpus.vocabulary;
+        const size_t first_word = corpus.stop_words.size();
+        const size_t rare_word_count = vocabulary.size() / 2;
+        std::vector<std::string> minus_queries;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            minus_queries.push_back("-"s + vocabulary[first_word] + " -"s + vocabulary[first_word + 1] + " "s
+                + vocabulary[vocabulary.size() - rare_word_count + i % rare_word_count]);
+        }
+        runner.Run("FindTopDocuments/seq/common-minus"s, minus_queries.size(), [&](size_t i) {
+            benchmark_sink += search_server.FindTopDocuments(std::execution::seq, minus_queries[i]).size();
+        });
+    }
+    {
+        // те же запросы с обязательными первыми двумя плюс-словами: пересечение списков вместо объединения
+        std::vector<std::string> required_queries;
+        for (const auto& query : queries) {
+            std::string required_query;
+            size_t required_count = 0;
+            for (const std::string_view word : SplitIntoWords(query)) {
+                if (word[0] != '-' && required_count < 2) {
+                    required_query.push_back('+');
+                    ++required_count;
+                }
+                required_query.append(word).push_back(' ');
+            }
+            required_queries.push_back(std::move(required_query));
+        }
+        runner.Run("FindTopDocuments/seq/required"s, required_queries.size(), [&](size_t i) {
+            benchmark_sink += search_server.FindTopDocuments(std::execution::seq, required_queries[i]).size();
+        });
+        runner.Run("FindTopDocuments/par/required"s, required_queries.size(), [&](size_t i) {
+            benchmark_sink += search_server.FindTopDocuments(std::execution::par, required_queries[i]).size();
+        });
+
+        SearchServer positional_server(corpus.stop_words);
+        positional_server.EnablePositionalIndex();
+        auto records = documents;
+        runner.Run("AddDocuments/positional"s, 1, [&](size_t) {
+            positional_server.AddDocuments(std::move(records));
+        });
+        benchmark_sink += positional_server.GetPositionsMemoryUsage();
+        // к запросу дописывается фраза из двух первых слов одного из документов
+        std::vector<std::string> phrase_queries;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto words = SplitIntoWords(documents[i * 7919 % documents.size()].text);
+            std::string phrase_query = queries[i];
+            if (words.size() >= 2) {
+                phrase_query += " \""s + std::string(words[0]) + " "s + std::string(words[1]) + "\""s;
+            }
+            phrase_queries.push_back(std::move(phrase_query));
+        }
+        runner.Run("FindTopDocuments/seq/phrase"s, phrase_queries.size(), [&](size_t i) {
+            benchmark_sink += positional_server.FindTopDocuments(std::execution::seq, phrase_queries[i]).size();
+        });
+    }
+    {
+        SearchServer compressed_server(search_server);
+        runner.Run("CompressPostings"s, 1, [&](size_t) {
+            compressed_server.CompressPostings();
+        });
+        benchmark_sink += compressed_server.GetPostingsMemoryUsage();
+        run_queries("FindTopDocuments/seq/compressed"s, [&](const std::string& query) {
+            return compressed_server.FindTopDocuments(std::execution::seq, query);
+        });
+        run_queries("FindTopDocuments/par/compressed"s, [&](const std::string& query) {
+            return compressed_server.FindTopDocuments(std::execution::par, query);
+        });
+    }
+    {
+        // перекошенный поток: девять запросов из десяти берутся из горячего процента запросов
+        std::mt19937 generator(options.seed);
+        const size_t hot_count = std::max<size_t>(queries.size() / 100, 1);
+        std::vector<size_t> stream(queries.size());
+        for (size_t& query_index : stream) {
+            query_index = generator() % 10 != 0 ? generator() % hot_count : generator() % queries.size();
+        }
+        const auto run_stream = [&](const std::string& name) {
+            runner.Run(name, stream.size(), [&](size_t i) {
+                benchmark_sink += search_server.FindTopDocuments(queries[stream[i]]).size();
+            });
+        };
+        run_stream("FindTopDocuments/skewed/uncached"s);
+        search_server.EnableQueryCache(64u << 20);
+        run_stream("FindTopDocuments/skewed/cached"s);
+        benchmark_sink += search_server.GetQueryCacheStats().hits;
+        search_server.DisableQueryCache();
+    }
+    {
+        ShardedSearchServer sharded_server(corpus.stop_words, 4);
+        runner.Run("Sharded/4/AddDocument"s, documents.size(), [&](size_t i) {
+            const auto& document = documents[i];
+            sharded_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        });
+        run_queries("Sharded/4/FindTopDocuments"s, [&](const std::string& query) {
+            return sharded_server.FindTopDocuments(query);
+        });
+    }
+    {
+        // читатели не должны замедляться, пока писатель непрерывно добавляет и удаляет документы
+        VersionedSearchServer versioned_server(search_server);
+        run_queries("Versioned/FindTopDocuments/idle"s, [&](const std::string& query) {
+            return versioned_server.FindTopDocuments(query);
+        });
+        std::atomic<bool> stop_writer = false;
+        std::thread writer([&] {
+            const int id_offset = static_cast<int>(documents.size()) * 2 + 1;
+            for (size_t i = 0; !stop_writer; ++i) {
+                const auto& document = documents[i % documents.size()];
+                const int document_id = id_offset + static_cast<int>(i);
+                versioned_server.AddDocument(document_id, document.text, document.status, document.ratings);
+                if (i >= 64) {
+                    versioned_server.RemoveDocument(document_id - 64);
+                }
+                if (i % 16 == 0) {
+                    versioned_server.Publish();
+                }
+            }
+        });
+        run_queries("Versioned/FindTopDocuments/under-writes"s, [&](const std::string& query) {
+            return versioned_server.FindTopDocuments(query);
+        });
+        stop_writer = true;
+        writer.join();
+        benchmark_sink += versioned_server.GetVersion();
+    }
+    runner.Run("ProcessQueriesJoined"s, 1, [&](size_t) {
+        benchmark_sink += ProcessQueriesJoined(search_server, queries).size();
+    });
+
+    runner.Run("MatchDocument/seq"s, queries.size(), [&](size_t i) {
+        const int document_id = documents[i * 7919 % documents.size()].id;
+        benchmark_sink += std::get<0>(search_server.MatchDocument(std::execution::seq, queries[i], document_id)).size();
+    });
+    runner.Run("MatchDocument/par"s, queries.size(), [&](size_t i) {
+        const int document_id = documents[i * 7919 % documents.size()].id;
+        benchmark_sink += std::get<0>(search_server.MatchDocument(std::execution::par, queries[i], document_id)).size();
+    });
+
+    {
+        const auto results = search_server.FindTopDocuments(queries.front(), {1000});
+        runner.Run("Paginate/10"s, queries.size(), [&](size_t) {
+            for (const auto& page : Paginate(results, 10)) {
+                benchmark_sink += page.end_r - page.begin_r;
+            }
+        });
+    }
+
+    {
+        RequestQueue request_queue(search_server);
+        runner.Run("RequestQueue::AddFindRequest"s, queries.size(), [&](size_t i) {
+            benchmark_sink += request_queue.AddFindRequest(queries[i]).size();
+        });
+        benchmark_sink += request_queue.GetNoResultRequests();
+        runner.Run("RequestQueue::GetStatistics/DAY"s, 100, [&](size_t) {
+            benchmark_sink += request_queue.GetStatistics(StatisticsWindow::DAY).p99_ns;
+        });
+    }
+
+    {
+        const std::string snapshot_path = "benchmark.snapshot"s;
+        runner.Run("SaveSnapshot"s, 1, [&](size_t) {
+            search_server.SaveSnapshot(snapshot_path);
+        });
+        runner.Run("LoadSnapshot"s, 1, [&](size_t) {
+            benchmark_sink += SearchServer::LoadSnapshot(snapshot_path).GetDocumentCount();
+        });
+        std::remove(snapshot_path.c_str());
+    }
+
+    {
+        SearchServer seq_copy(search_server);
+        SearchServer par_copy(search_server);
+        // RemoveDuplicates печатает каждый найденный дубликат, в отчёт это не должно попасть
+        std::ostringstream removed_log;
+        auto* const cout_buffer = std::cout.rdbuf(removed_log.rdbuf());
+        runner.Run("RemoveDuplicates/seq"s, 1, [&](size_t) {
+            RemoveDuplicates(std::execution::seq, seq_copy);
+        });
+        runner.Run("RemoveDuplicates/par"s, 1, [&](size_t) {
+            RemoveDuplicates(std::execution::par, par_copy);
+        });
+        std::cout.rdbuf(cout_buffer);
+        benchmark_sink += seq_copy.GetDocumentCount() + par_copy.GetDocumentCount();
+    }
+    runner.Run("FindNearDuplicates/0.8"s, 1, [&](size_t) {
+        benchmark_sink += FindNearDuplicates(search_server, 0.8).size();
+    });
+    {
+        SearchServer rejecting_server(corpus.stop_words);
+        rejecting_server.SetDuplicateMode(DuplicateMode::REJECT);
+        runner.Run("AddDocument/reject-duplicates"s, documents.size(), [&](size_t i) {
+            const DocumentRecord& document = documents[i];
+            try {
+                rejecting_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            } catch (const std::invalid_argument&) {
+                ++benchmark_sink;
+            }
+        });
+    }
+
+    {
+        // запросы из 10+ плюс-слов по корпусу не меньше чем из 100 тысяч документов
+        CorpusOptions long_query_options = options;
+        long_query_options.document_count = std::max<size_t>(options.document_count, 100000);
+        long_query_options.query_length = std::max<size_t>(options.query_length, 12);
+        long_query_options.minus_word_probability = 0;
+        long_query_options.query_count = std::min<size_t>(options.query_count, 500);
+        Corpus large_corpus = GenerateCorpus(long_query_options);
+        SearchServer large_server(large_corpus.stop_words);
+        large_server.AddDocuments(std::move(large_corpus.documents));
+        const auto& long_queries = large_corpus.queries;
+        runner.Run("FindTopDocuments/seq/long-queries-100k"s, long_queries.size(), [&](size_t i) {
+            benchmark_sink += large_server.FindTopDocuments(std::execution::seq, long_queries[i]).size();
+        });
+        runner.Run("FindTopDocuments/par/long-queries-100k"s, long_queries.size(), [&](size_t i) {
+            benchmark_sink += large_server.FindTopDocuments(std::execution::par, long_queries[i]).size();
+        });
+    }
+
+    const size_t removed_count = documents.size() / 2;
+    {
+        SearchServer server_copy(search_server);
+        runner.Run("RemoveDocument/seq"s, removed_count, [&](size_t i) {
+            server_copy.RemoveDocument(std::execution::seq, documents[i].id);
+        });
+    }
+    {
+        SearchServer server_copy(search_server);
+        runner.Run("RemoveDocument/par"s, removed_count, [&](size_t i) {
+            server_copy.RemoveDocument(std::execution::par, documents[i].id);
+        });
+    }
+    {
+        // документы из 10 000 различных слов: удаление каждого затрагивает 10 000 списков вхождений.
+        // Шаг 3 по словарю из 50 000 слов не повторяет слов внутри документа
+        std::mt19937 generator(options.seed);
+        const auto wide_vocabulary = GenerateVocabulary(generator, 50000);
+        const int wide_document_count = 200;
+        const size_t words_per_document = 10000;
+        SearchServer wide_server(""s);
+        for (int i = 0; i < wide_document_count; ++i) {
+            std::string text;
+            for (size_t j = 0; j < words_per_document; ++j) {
+                text += wide_vocabulary[(i * 7 + j * 3) % wide_vocabulary.size()];
+                text.push_back(' ');
+            }
+            wide_server.AddDocument(i, text, DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        runner.Run("RemoveDocument/seq/10000-words"s, wide_document_count / 2, [&](size_t i) {
+            wide_server.RemoveDocument(std::execution::seq, static_cast<int>(2 * i));
+        });
+        runner.Run("RemoveDocument/par/10000-words"s, wide_document_count / 2, [&](size_t i) {
+            wide_server.RemoveDocument(std::execution::par, static_cast<int>(2 * i + 1));
+        });
+        benchmark_sink += wide_server.GetDocumentCount();
+    }
+
+    // контрольная сумма читает benchmark_sink, без этого чтения компилятор вправе выбросить записи в него
+    if (progress != nullptr) {
+        *progress << "checksum "s << benchmark_sink << std::endl;
+    }
+    return runner.GetResults();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "document.h"
+
+// Параметры синтетического корпуса. Слова выбираются по закону Ципфа:
+// вероятность слова ранга r пропорциональна 1 / r^zipf_exponent
+struct CorpusOptions {
+    size_t vocabulary_size = 20000;
+    double zipf_exponent = 1.0;
+    size_t document_count = 50000;
+    size_t min_document_length = 10;
+    size_t max_document_length = 100;
+    // доли документов с соответствующими статусами, остальные - ACTUAL
+    double irrelevant_share = 0.1;
+    double banned_share = 0.1;
+    double removed_share = 0.05;
+    // доля документов, повторяющих набор слов одного из предыдущих
+    double duplicate_share = 0.02;
+    int min_rating = -10;
+    int max_rating = 10;
+    size_t ratings_per_document = 3;
+    size_t query_count = 2000;
+    size_t query_length = 5;
+    double minus_word_probability = 0.1;
+    uint32_t seed = 42;
+};
+
+struct Corpus {
+    // слова по убыванию частоты
+    std::vector<std::string> vocabulary;
+    std::vector<std::string> stop_words;
+    std::vector<DocumentRecord> documents;
+    std::vector<std::string> queries;
+};
+
+Corpus GenerateCorpus(const CorpusOptions& options);
+
+// Результат одного замера; времена в наносекундах
+struct BenchmarkResult {
+    std::string name;
+    size_t operation_count = 0;
+    double total_seconds = 0;
+    double ns_per_operation = 0;
+    double operations_per_second = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t max_ns = 0;
+    // пик резидентной памяти процесса на момент окончания замера
+    uint64_t peak_rss_kb = 0;
+    // только для замеров, обрабатывающих известный объём данных
+    double gigabytes_per_second = 0;
+    // только для замеров с отсечением: доля документов из списков слов запроса, которые полный перебор
+    // просмотрел бы, а отсечение пропустило. Считается по счётчику postings_scanned и без статистики равна 0
+    double postings_skipped_fraction = 0;
+};
+
+// Пик резидентной памяти процесса с его запуска
+uint64_t GetPeakRssKb();
+
+// Сколько документов из списков слов просмотрели поиски с запуска; 0 в сборке без статистики
+uint64_t GetPostingsScanned();
+
+// Выполняет операции по одной, замеряя каждую, и копит результаты
+class BenchmarkRunner {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Если progress задан, в него пишется строка по каждому завершённому замеру
+    explicit BenchmarkRunner(std::ostream* progress = nullptr);
+
+    // operation(i) вызывается для i от 0 до operation_count - 1
+    template <typename Operation>
+    const BenchmarkResult& Run(const std::string& name, size_t operation_count, Operation operation) {
+        std::vector<uint64_t> samples(operation_count);
+        const auto start_time = Clock::now();
+        for (size_t i = 0; i < operation_count; ++i) {
+            const auto operation_start = Clock::now();
+            operation(i);
+            samples[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - operation_start).count();
+        }
+        const auto duration = Clock::now() - start_time;
+        return AddResult(name, std::move(samples), std::chrono::duration<double>(duration).count());
+    }
+
+    // То же, но каждая операция обрабатывает bytes_per_operation байт, и результат дополняется пропускной способностью
+    template <typename Operation>
+    const BenchmarkResult& RunThroughput(const std::string& name, size_t operation_count, size_t bytes_per_operation,
+                                         Operation operation) {
+        Run(name, operation_count, operation);
+        BenchmarkResult& result = results_.back();
+        if (result.total_seconds > 0) {
+            result.gigabytes_per_second = 1e-9 * bytes_per_operation * operation_count / result.total_seconds;
+        }
+        return result;
+    }
+
+    // То же для поиска с отсечением; результат дополняется долей документов, пропущенных против
+    // exhaustive_postings_scanned документов, которые просмотрел полный перебор тех же операций
+    template <typename Operation>
+    const BenchmarkResult& RunPruned(const std::string& name, size_t operation_count,
+                                     uint64_t exhaustive_postings_scanned, Operation operation) {
+        const uint64_t postings_scanned_before = GetPostingsScanned();
+        Run(name, operation_count, operation);
+        BenchmarkResult& result = results_.back();
+        if (exhaustive_postings_scanned > 0) {
+            result.postings_skipped_fraction = 1.0
+                - static_cast<double>(GetPostingsScanned() - postings_scanned_before) / exhaustive_postings_scanned;
+        }
+        return result;
+    }
+
+    const std::vector<BenchmarkResult>& GetResults() const;
+
+private:
+    std::ostream* progress_;
+    std::vector<BenchmarkResult> results_;
+
+    const BenchmarkResult& AddResult(const std::string& name, std::vector<uint64_t> samples, double total_seconds);
+};
+
+enum class ReportFormat {
+    TEXT,
+    JSON,
+};
+
+// JSON - массив объектов с полями BenchmarkResult, по одному объекту на строку
+void PrintBenchmarkReport(std::ostream& out, const CorpusOptions& options,
+                          const std::vector<BenchmarkResult>& results, ReportFormat format);
+
+// Замеряет все операции поискового сервера на корпусе с параметрами options.
+// В progress, если он задан, пишется ход замеров и контрольная сумма результатов
+std::vector<BenchmarkResult> RunSearchServerBenchmarks(const CorpusOptions& options, std::ostream* progress = nullptr);
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "benchmark.h"
+
+using namespace std;
+
+// Отдельная программа замеров, цель benchmark в CMakeLists.txt. Параметры: --documents=N --vocabulary=N
+// --zipf=S --min-length=N --max-length=N --queries=N --query-length=N --seed=N --format=text|json --verbose.
+// С --verbose ход замеров печатается в stderr, иначе stderr остаётся пустым
+int main(int argc, char* argv[]) {
+    CorpusOptions options;
+    ReportFormat format = ReportFormat::TEXT;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t equals = argument.find('=');
+        const string_view name = argument.substr(0, equals);
+        const string value = equals == string_view::npos ? ""s : string(argument.substr(equals + 1));
+        if (name == "--documents") {
+            options.document_count = stoul(value);
+        } else if (name == "--vocabulary") {
+            options.vocabulary_size = stoul(value);
+        } else if (name == "--zipf") {
+            options.zipf_exponent = stod(value);
+        } else if (name == "--min-length") {
+            options.min_document_length = stoul(value);
+        } else if (name == "--max-length") {
+            options.max_document_length = stoul(value);
+        } else if (name == "--queries") {
+            options.query_count = stoul(value);
+        } else if (name == "--query-length") {
+            options.query_length = stoul(value);
+        } else if (name == "--seed") {
+            options.seed = stoul(value);
+        } else if (name == "--format") {
+            format = value == "json"s ? ReportFormat::JSON : ReportFormat::TEXT;
+        } else if (name == "--verbose") {
+            verbose = true;
+        } else {
+            cerr << "Unknown argument "s << argument << endl;
+            return 1;
+        }
+    }
+
+    const auto results = RunSearchServerBenchmarks(options, verbose ? &cerr : nullptr);
+    PrintBenchmarkReport(cout, options, results, format);
+}
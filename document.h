@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <ostream>
+#include <string>
+#include <vector>
 
 using namespace std::string_literals;
 
-enum class DocumentStatus {
+enum class DocumentStatus : uint8_t {
     ACTUAL,
     IRRELEVANT,
     BANNED,
@@ -25,4 +28,12 @@ struct Document {
     int rating = 0;
 };
 
+// Документ, ещё не добавленный в поисковый сервер
+struct DocumentRecord {
+    int id = 0;
+    std::string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 std::ostream& operator<<(std::ostream& out, const Document& doc);
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <stdexcept>
+
+#include "index_snapshot.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Дожидается, пока содержимое файла или каталога окажется на диске
+void SyncToDisk(const std::string& path, int flags) {
+    const int fd = open(path.c_str(), flags);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    const int result = fsync(fd);
+    close(fd);
+    if (result != 0) {
+        throw std::runtime_error("Cannot sync "s + path);
+    }
+}
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t index_offset;
+    uint64_t index_size;
+    uint64_t index_checksum;
+};
+
+// Так пишется положение блока в оглавлении
+struct BlockDescriptor {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+const size_t BLOCK_ALIGNMENT = 8;
+
+}
+
+uint64_t ComputeSnapshotChecksum(std::string_view data, uint64_t hash) {
+    for (const char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+    MappedFile::MappedFile(const std::string& path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open snapshot "s + path);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat snapshot "s + path);
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map snapshot "s + path);
+            }
+            data_ = static_cast<const char*>(data);
+        }
+        close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    std::string_view MappedFile::GetData() const {
+        return {data_, size_};
+    }
+
+    SnapshotWriter::SnapshotWriter(const std::string& path)
+        : path_(path)
+        , temp_path_(path + ".tmp"s)
+        , out_(temp_path_, std::ios::binary | std::ios::trunc)
+    {
+        if (!out_) {
+            throw std::runtime_error("Cannot create snapshot "s + temp_path_);
+        }
+        // место под заголовок, он станет известен только в конце
+        const SnapshotHeader header{};
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file_size_ = sizeof(header);
+    }
+
+    SnapshotWriter::~SnapshotWriter() {
+        if (!committed_) {
+            out_.close();
+            std::remove(temp_path_.c_str());
+        }
+    }
+
+    void SnapshotWriter::WriteString(std::string_view str) {
+        Write<uint32_t>(str.size());
+        index_.append(str);
+    }
+
+    void SnapshotWriter::Commit() {
+        AlignFile();
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.index_offset = file_size_;
+        header.index_size = index_.size();
+        header.index_checksum = ComputeSnapshotChecksum(index_);
+        out_.write(index_.data(), index_.size());
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("Cannot write snapshot "s + temp_path_);
+        }
+        // без fsync переименование может попасть на диск раньше данных, и после сбоя
+        // под именем path окажется пустой или оборванный файл
+        SyncToDisk(temp_path_, O_RDONLY);
+        if (std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+            throw std::runtime_error("Cannot replace snapshot "s + path_);
+        }
+        committed_ = true;
+        // само переименование - запись в каталог, её тоже нужно сбросить
+        const size_t slash = path_.rfind('/');
+        SyncToDisk(slash == std::string::npos ? "."s : slash == 0 ? "/"s : path_.substr(0, slash),
+                   O_RDONLY | O_DIRECTORY);
+    }
+
+    void SnapshotWriter::WriteBlockBytes(std::string_view bytes) {
+        AlignFile();
+        Write(BlockDescriptor{file_size_, bytes.size(), ComputeSnapshotChecksum(bytes)});
+        out_.write(bytes.data(), bytes.size());
+        file_size_ += bytes.size();
+    }
+
+    void SnapshotWriter::AlignFile() {
+        static const char zeros[BLOCK_ALIGNMENT] = {};
+        const size_t padding = (BLOCK_ALIGNMENT - file_size_ % BLOCK_ALIGNMENT) % BLOCK_ALIGNMENT;
+        out_.write(zeros, padding);
+        file_size_ += padding;
+    }
+
+    bool SnapshotBlock::IsIntact() const {
+        return ComputeSnapshotChecksum(bytes) == checksum;
+    }
+
+    SnapshotReader::SnapshotReader(std::string_view file_data) {
+        SnapshotHeader header;
+        if (file_data.size() < sizeof(header)) {
+            ThrowCorrupted();
+        }
+        std::memcpy(&header, file_data.data(), sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("File is not a search server snapshot"s);
+        }
+        if (header.version != SNAPSHOT_VERSION) {
+            throw std::runtime_error("Unsupported snapshot version "s + std::to_string(header.version));
+        }
+        // оглавление - последнее в файле, поэтому оборванный файл его не содержит
+        if (header.index_offset < sizeof(header) || header.index_offset > file_data.size()
+            || header.index_size != file_data.size() - header.index_offset) {
+            ThrowCorrupted();
+        }
+        blocks_ = file_data.substr(0, header.index_offset);
+        payload_ = file_data.substr(header.index_offset);
+        if (ComputeSnapshotChecksum(payload_) != header.index_checksum) {
+            ThrowCorrupted();
+        }
+    }
+
+    std::string_view SnapshotReader::ReadString() {
+        const uint32_t size = Read<uint32_t>();
+        return {Take(size), size};
+    }
+
+    bool SnapshotReader::AtEnd() const {
+        return payload_.empty();
+    }
+
+    const char* SnapshotReader::Take(size_t size) {
+        if (size > payload_.size()) {
+            ThrowCorrupted();
+        }
+        const char* data = payload_.data();
+        payload_.remove_prefix(size);
+        return data;
+    }
+
+    SnapshotBlock SnapshotReader::ReadBlockBytes(uint64_t count, size_t value_size) {
+        const auto descriptor = Read<BlockDescriptor>();
+        // блок не может заходить на заголовок и оглавление
+        if (descriptor.offset < sizeof(SnapshotHeader) || descriptor.offset > blocks_.size()
+            || descriptor.size > blocks_.size() - descriptor.offset
+            || count > descriptor.size / value_size || count * value_size != descriptor.size) {
+            ThrowCorrupted();
+        }
+        return {blocks_.substr(descriptor.offset, descriptor.size), descriptor.checksum};
+    }
+
+    void SnapshotReader::ThrowCorrupted() {
+        throw std::runtime_error("Snapshot is corrupted"s);
+    }
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Формат снимка индекса: заголовок, блоки данных и оглавление.
+// Блоки - массивы, которые загруженный сервер читает прямо из отображённого в память файла; каждый
+// выровнен по 8 байтам, а его положение и контрольная сумма записаны в оглавлении. Оглавление - всё
+// остальное: стоп-слова, таблица документов, словарь и описания блоков. Заголовок - сигнатура, версия
+// формата, положение, размер и контрольная сумма оглавления.
+// Числа записываются в порядке байтов машины, снимок переносим только между машинами
+// с одинаковым порядком байтов
+const char SNAPSHOT_MAGIC[8] = {'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 4;
+
+const uint64_t SNAPSHOT_CHECKSUM_SEED = 14695981039346656037ULL;
+
+// FNV-1a по 64 битам; hash позволяет продолжить подсчёт с предыдущего куска данных
+uint64_t ComputeSnapshotChecksum(std::string_view data, uint64_t hash = SNAPSHOT_CHECKSUM_SEED);
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    std::string_view GetData() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Блок данных снимка внутри отображённого файла
+struct SnapshotBlock {
+    std::string_view bytes;
+    uint64_t checksum = 0;
+
+    // Совпадает ли контрольная сумма байтов блока с записанной в оглавлении
+    bool IsIntact() const;
+
+    template <typename T>
+    const T* GetValues() const {
+        return reinterpret_cast<const T*>(bytes.data());
+    }
+};
+
+// Пишет блоки данных во временный файл рядом с path, а оглавление копит в памяти. Commit дописывает
+// оглавление и заголовок, сбрасывает файл на диск и подменяет им path, так что ни читатели,
+// ни перезапуск после сбоя не застанут под именем path недописанный снимок
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path);
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Если Commit не был вызван, временный файл удаляется
+    ~SnapshotWriter();
+
+    // Write, WriteArray и WriteString пишут в оглавление
+    template <typename T>
+    void Write(const T& value) {
+        index_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        Write<uint64_t>(values.size());
+        index_.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void WriteString(std::string_view str);
+
+    // Пишет count значений блоком данных, а в оглавление - положение блока и его контрольную сумму
+    template <typename T>
+    void WriteBlock(const T* values, size_t count) {
+        WriteBlockBytes({reinterpret_cast<const char*>(values), count * sizeof(T)});
+    }
+
+    void Commit();
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+    uint64_t file_size_ = 0;
+    std::string index_;
+    bool committed_ = false;
+
+    void WriteBlockBytes(std::string_view bytes);
+
+    // Дописывает нули до границы 8 байт
+    void AlignFile();
+};
+
+// Читает оглавление снимка, проверив заголовок и контрольную сумму оглавления. Блоки данных
+// не копируются и не проверяются: ReadBlock отдаёт их место в файле, а контрольную сумму блока
+// проверяет SnapshotBlock::IsIntact. При любом несоответствии формату бросает std::runtime_error
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view file_data);
+
+    template <typename T>
+    T Read() {
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Данные копируются целиком, поэтому выравнивание внутри файла не важно
+    template <typename T>
+    std::vector<T> ReadArray() {
+        const uint64_t size = Read<uint64_t>();
+        if (size > payload_.size() / sizeof(T)) {
+            ThrowCorrupted();
+        }
+        std::vector<T> values(size);
+        // у пустого вектора data() может быть нулевым указателем, а memcpy его не принимает
+        if (size > 0) {
+            std::memcpy(values.data(), Take(size * sizeof(T)), size * sizeof(T));
+        }
+        return values;
+    }
+
+    std::string_view ReadString();
+
+    // Блок из count значений типа T: проверяется, что он лежит в области блоков и выровнен под T
+    template <typename T>
+    SnapshotBlock ReadBlock(uint64_t count) {
+        const SnapshotBlock block = ReadBlockBytes(count, sizeof(T));
+        if (reinterpret_cast<uintptr_t>(block.bytes.data()) % alignof(T) != 0) {
+            ThrowCorrupted();
+        }
+        return block;
+    }
+
+    bool AtEnd() const;
+
+    [[noreturn]] static void ThrowCorrupted();
+
+private:
+    // область блоков данных между заголовком и оглавлением
+    std::string_view blocks_;
+    // непрочитанная часть оглавления
+    std::string_view payload_;
+
+    const char* Take(size_t size);
+
+    SnapshotBlock ReadBlockBytes(uint64_t count, size_t value_size);
+};
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "instrumentation.h"
+
+using namespace std::string_literals;
+
+    StatsRegistry::StatsRegistry()
+        : threads_{&retired_}
+    {
+    }
+
+    StatsRegistry& StatsRegistry::Instance() {
+        static StatsRegistry registry;
+        return registry;
+    }
+
+    size_t StatsRegistry::RegisterTimer(const std::string& name) {
+        return Register(timer_names_, name);
+    }
+
+    size_t StatsRegistry::RegisterCounter(const std::string& name) {
+        return Register(counter_names_, name);
+    }
+
+    void StatsRegistry::RecordDuration(size_t timer, uint64_t duration_ns) {
+        auto& slot = GetThreadStats().timers[timer];
+        ThreadTimer* thread_timer = slot.load(std::memory_order_relaxed);
+        if (thread_timer == nullptr) {
+            thread_timer = new ThreadTimer();
+            slot.store(thread_timer, std::memory_order_release);
+        }
+        auto& bucket = thread_timer->buckets[LatencyHistogram::GetBucketIndex(duration_ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        thread_timer->total_ns.store(thread_timer->total_ns.load(std::memory_order_relaxed) + duration_ns,
+                                     std::memory_order_relaxed);
+    }
+
+    void StatsRegistry::AddToCounter(size_t counter, uint64_t value) {
+        auto& slot = GetThreadStats().counters[counter];
+        slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    StatsRegistry::Snapshot StatsRegistry::Collect() const {
+        std::lock_guard guard(mutex_);
+        Snapshot snapshot;
+        for (size_t timer = 0; timer < timer_names_.size(); ++timer) {
+            TimerStats stats;
+            stats.name = timer_names_[timer];
+            for (const ThreadStats* thread_stats : threads_) {
+                const ThreadTimer* thread_timer = thread_stats->timers[timer].load(std::memory_order_acquire);
+                if (thread_timer == nullptr) {
+                    continue;
+                }
+                for (int bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+                    stats.latencies.RecordBucket(bucket, thread_timer->buckets[bucket].load(std::memory_order_relaxed));
+                }
+                stats.total_ns += thread_timer->total_ns.load(std::memory_order_relaxed);
+            }
+            snapshot.timers.push_back(std::move(stats));
+        }
+        for (size_t counter = 0; counter < counter_names_.size(); ++counter) {
+            CounterStats stats;
+            stats.name = counter_names_[counter];
+            for (const ThreadStats* thread_stats : threads_) {
+                stats.value += thread_stats->counters[counter].load(std::memory_order_relaxed);
+            }
+            snapshot.counters.push_back(std::move(stats));
+        }
+        return snapshot;
+    }
+
+    void StatsRegistry::Reset() {
+        // сброс идёт мимо потоков-владельцев, поэтому замеры, идущие одновременно с ним, могут потеряться
+        std::lock_guard guard(mutex_);
+        for (ThreadStats* thread_stats : threads_) {
+            for (auto& slot : thread_stats->timers) {
+                if (ThreadTimer* thread_timer = slot.load(std::memory_order_acquire)) {
+                    for (auto& bucket : thread_timer->buckets) {
+                        bucket.store(0, std::memory_order_relaxed);
+                    }
+                    thread_timer->total_ns.store(0, std::memory_order_relaxed);
+                }
+            }
+            for (auto& counter : thread_stats->counters) {
+                counter.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    StatsRegistry::ThreadStats::~ThreadStats() {
+        for (auto& slot : timers) {
+            delete slot.load(std::memory_order_relaxed);
+        }
+    }
+
+    StatsRegistry::ThreadStatsOwner::~ThreadStatsOwner() {
+        if (stats != nullptr) {
+            StatsRegistry::Instance().RetireThread(stats);
+            delete stats;
+            stats = nullptr;
+        }
+    }
+
+    size_t StatsRegistry::Register(std::vector<std::string>& names, const std::string& name) {
+        std::lock_guard guard(mutex_);
+        const auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end()) {
+            return it - names.begin();
+        }
+        if (names.size() == MAX_METRICS) {
+            throw std::length_error("Too many metrics, the limit is "s + std::to_string(MAX_METRICS));
+        }
+        names.push_back(name);
+        return names.size() - 1;
+    }
+
+    StatsRegistry::ThreadStats& StatsRegistry::GetThreadStats() {
+        // метрики потока живут до его завершения, а потом остаются в статистике суммой в retired_
+        thread_local ThreadStatsOwner owner;
+        if (owner.stats == nullptr) {
+            owner.stats = new ThreadStats();
+            std::lock_guard guard(mutex_);
+            threads_.push_back(owner.stats);
+        }
+        return *owner.stats;
+    }
+
+    void StatsRegistry::RetireThread(ThreadStats* thread_stats) {
+        // вызывается самим завершающимся потоком, поэтому его значения можно читать relaxed
+        std::lock_guard guard(mutex_);
+        for (size_t timer = 0; timer < MAX_METRICS; ++timer) {
+            const ThreadTimer* thread_timer = thread_stats->timers[timer].load(std::memory_order_relaxed);
+            if (thread_timer == nullptr) {
+                continue;
+            }
+            ThreadTimer* retired_timer = retired_.timers[timer].load(std::memory_order_relaxed);
+            if (retired_timer == nullptr) {
+                retired_timer = new ThreadTimer();
+                retired_.timers[timer].store(retired_timer, std::memory_order_release);
+            }
+            for (int bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+                auto& retired_bucket = retired_timer->buckets[bucket];
+                retired_bucket.store(retired_bucket.load(std::memory_order_relaxed)
+                    + thread_timer->buckets[bucket].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            retired_timer->total_ns.store(retired_timer->total_ns.load(std::memory_order_relaxed)
+                + thread_timer->total_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        for (size_t counter = 0; counter < MAX_METRICS; ++counter) {
+            auto& retired_counter = retired_.counters[counter];
+            retired_counter.store(retired_counter.load(std::memory_order_relaxed)
+                + thread_stats->counters[counter].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        threads_.erase(std::find(threads_.begin(), threads_.end(), thread_stats));
+    }
+
+void PrintStatsSnapshot(std::ostream& out, const StatsRegistry::Snapshot& snapshot, StatsFormat format) {
+    if (format == StatsFormat::TEXT) {
+        for (const auto& timer : snapshot.timers) {
+            out << "timer "s << timer.name << ": count "s << timer.latencies.GetCount()
+                << ", total "s << timer.total_ns << " ns, p50 "s << timer.latencies.GetPercentile(0.5)
+                << " ns, p99 "s << timer.latencies.GetPercentile(0.99)
+                << " ns, p999 "s << timer.latencies.GetPercentile(0.999) << " ns\n"s;
+        }
+        for (const auto& counter : snapshot.counters) {
+            out << "counter "s << counter.name << ": "s << counter.value << '\n';
+        }
+        return;
+    }
+
+    out << "\"timers\": ["s;
+    for (size_t i = 0; i < snapshot.timers.size(); ++i) {
+        const auto& timer = snapshot.timers[i];
+        out << (i > 0 ? ", "s : ""s) << "{\"name\": \""s << timer.name
+            << "\", \"count\": "s << timer.latencies.GetCount()
+            << ", \"total_ns\": "s << timer.total_ns
+            << ", \"p50_ns\": "s << timer.latencies.GetPercentile(0.5)
+            << ", \"p99_ns\": "s << timer.latencies.GetPercentile(0.99)
+            << ", \"p999_ns\": "s << timer.latencies.GetPercentile(0.999) << '}';
+    }
+    out << "], \"counters\": ["s;
+    for (size_t i = 0; i < snapshot.counters.size(); ++i) {
+        const auto& counter = snapshot.counters[i];
+        out << (i > 0 ? ", "s : ""s) << "{\"name\": \""s << counter.name
+            << "\", \"value\": "s << counter.value << '}';
+    }
+    out << ']';
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "log_duration.h"
+
+// Реестр таймеров и счётчиков горячих путей. Каждый поток пишет в собственные атомарные
+// гистограммы и счётчики без блокировок и без конкуренции за кеш-линии; чтение сливает потоки.
+// Сборка с SEARCH_SERVER_DISABLE_STATS превращает STATS_SCOPED_TIMER и STATS_COUNTER_ADD в пустоту
+class StatsRegistry {
+public:
+    // столько разных таймеров и столько разных счётчиков можно зарегистрировать
+    static const size_t MAX_METRICS = 64;
+
+    struct TimerStats {
+        std::string name;
+        LatencyHistogram latencies;
+        uint64_t total_ns = 0;
+    };
+
+    struct CounterStats {
+        std::string name;
+        uint64_t value = 0;
+    };
+
+    struct Snapshot {
+        std::vector<TimerStats> timers;
+        std::vector<CounterStats> counters;
+    };
+
+    static StatsRegistry& Instance();
+
+    // Повторная регистрация имени возвращает тот же номер
+    size_t RegisterTimer(const std::string& name);
+
+    size_t RegisterCounter(const std::string& name);
+
+    void RecordDuration(size_t timer, uint64_t duration_ns);
+
+    void AddToCounter(size_t counter, uint64_t value);
+
+    // Значения потоков, в том числе завершившихся
+    Snapshot Collect() const;
+
+    void Reset();
+
+private:
+    struct ThreadTimer {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> total_ns = 0;
+    };
+
+    // Метрики одного потока; пишет только он, поэтому хватает relaxed load и store без RMW
+    struct ThreadStats {
+        std::array<std::atomic<ThreadTimer*>, MAX_METRICS> timers{};
+        std::array<std::atomic<uint64_t>, MAX_METRICS> counters{};
+
+        ~ThreadStats();
+    };
+
+    // Метриками потока владеет сам поток; при его завершении они сливаются в retired_ и удаляются
+    struct ThreadStatsOwner {
+        ThreadStats* stats = nullptr;
+
+        ~ThreadStatsOwner();
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> timer_names_;
+    std::vector<std::string> counter_names_;
+    // сумма метрик завершившихся потоков; пишется только под mutex_
+    ThreadStats retired_;
+    // метрики живых потоков и первым элементом retired_, так что чтение обходит один список,
+    // а его длина не растёт при постоянном создании и завершении потоков
+    std::vector<ThreadStats*> threads_;
+
+    StatsRegistry();
+
+    size_t Register(std::vector<std::string>& names, const std::string& name);
+
+    ThreadStats& GetThreadStats();
+
+    // Сливает метрики завершающегося потока в retired_ и убирает их из threads_
+    void RetireThread(ThreadStats* thread_stats);
+};
+
+enum class StatsFormat {
+    TEXT,
+    JSON,
+};
+
+// TEXT - строка на метрику; JSON - поля "timers" и "counters" без охватывающих скобок,
+// чтобы вызывающий мог дописать к ним свои поля
+void PrintStatsSnapshot(std::ostream& out, const StatsRegistry::Snapshot& snapshot, StatsFormat format);
+
+// Записывает время жизни в таймер реестра с точностью до наносекунд
+class ScopedStatsTimer {
+public:
+    using Clock = LogDuration::Clock;
+
+    explicit ScopedStatsTimer(size_t timer)
+        : timer_(timer)
+    {
+    }
+
+    ~ScopedStatsTimer() {
+        StatsRegistry::Instance().RecordDuration(timer_,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_).count());
+    }
+
+private:
+    const size_t timer_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+#ifndef SEARCH_SERVER_DISABLE_STATS
+
+// Имя регистрируется один раз на месте вызова, дальше замер стоит два чтения часов
+#define STATS_SCOPED_TIMER(name) \
+    static const size_t PROFILE_CONCAT(stats_timer_, __LINE__) = StatsRegistry::Instance().RegisterTimer(name); \
+    const ScopedStatsTimer PROFILE_CONCAT(stats_guard_, __LINE__)(PROFILE_CONCAT(stats_timer_, __LINE__))
+
+#define STATS_COUNTER_ADD(name, value) \
+    do { \
+        static const size_t stats_counter = StatsRegistry::Instance().RegisterCounter(name); \
+        StatsRegistry::Instance().AddToCounter(stats_counter, (value)); \
+    } while (false)
+
+#else
+
+#define STATS_SCOPED_TIMER(name) static_cast<void>(0)
+#define STATS_COUNTER_ADD(name, value) static_cast<void>(0)
+
+#endif
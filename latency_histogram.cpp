@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <cmath>
+
+#include "latency_histogram.h"
+
+    void LatencyHistogram::Record(uint64_t duration_ns) {
+        ++counts_[GetBucketIndex(duration_ns)];
+        ++count_;
+    }
+
+    void LatencyHistogram::RecordBucket(int bucket_index, uint64_t count) {
+        counts_[bucket_index] += count;
+        count_ += count;
+    }
+
+    void LatencyHistogram::Merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+    }
+
+    void LatencyHistogram::Clear() {
+        counts_.fill(0);
+        count_ = 0;
+    }
+
+    uint64_t LatencyHistogram::GetCount() const {
+        return count_;
+    }
+
+    uint64_t LatencyHistogram::GetPercentile(double quantile) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * count_)));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                const uint64_t lower = GetBucketLowerBound(i);
+                const uint64_t upper = i + 1 < BUCKET_COUNT ? GetBucketLowerBound(i + 1) : lower * 2;
+                return lower + (upper - lower) / 2;
+            }
+        }
+        return GetBucketLowerBound(BUCKET_COUNT - 1);
+    }
+
+    int LatencyHistogram::GetBucketIndex(uint64_t duration_ns) {
+        // малые значения лежат в первых корзинах по одному на корзину
+        if (duration_ns < SUB_BUCKETS) {
+            return static_cast<int>(duration_ns);
+        }
+        int exponent = 63 - __builtin_clzll(duration_ns);
+        if (exponent >= MAX_EXPONENT) {
+            return BUCKET_COUNT - 1;
+        }
+        const int sub_bucket = static_cast<int>((duration_ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+    }
+
+    uint64_t LatencyHistogram::GetBucketLowerBound(int bucket_index) {
+        if (bucket_index < SUB_BUCKETS) {
+            return bucket_index;
+        }
+        const int exponent = bucket_index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+        const uint64_t sub_bucket = bucket_index % SUB_BUCKETS;
+        return (uint64_t{1} << exponent) + (sub_bucket << (exponent - SUB_BUCKET_BITS));
+    }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Гистограмма длительностей в наносекундах с логарифмическими корзинами:
+// каждая степень двойки делится на SUB_BUCKETS равных частей, поэтому относительная
+// погрешность перцентиля не больше 1 / SUB_BUCKETS, а размер не зависит от числа замеров
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // длительности от 2^MAX_EXPONENT нс (~18 минут) попадают в последнюю корзину
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void Record(uint64_t duration_ns);
+
+    // Добавляет count замеров в корзину bucket_index, например при сборе из атомарных счётчиков
+    void RecordBucket(int bucket_index, uint64_t count);
+
+    static int GetBucketIndex(uint64_t duration_ns);
+
+    void Merge(const LatencyHistogram& other);
+
+    void Clear();
+
+    uint64_t GetCount() const;
+
+    // Значение, не меньше которого доля quantile замеров (середина корзины); 0 для пустой гистограммы
+    uint64_t GetPercentile(double quantile) const;
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts_{};
+    uint64_t count_ = 0;
+
+    static uint64_t GetBucketLowerBound(int bucket_index);
+};
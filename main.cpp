@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "request_queue.h"
@@ -10,7 +11,7 @@
 
 using namespace std;
 
-void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
+void AddDocument(SearchServer& search_server, int document_id, std::string_view document, DocumentStatus status,
                      const std::vector<int>& ratings) {
     search_server.AddDocument(document_id, document, status, ratings);
 }
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "near_duplicates.h"
+#include "string_processing.h"
+
+using namespace std;
+
+namespace {
+
+uint64_t MixHash(uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
+// Число полос и строк в полосе: из заданных в options или подобранных по порогу
+pair<size_t, size_t> ChooseBands(double threshold, const NearDuplicateOptions& options) {
+    if (options.bands > 0 && options.rows_per_band > 0) {
+        return {options.bands, options.rows_per_band};
+    }
+    if (options.signature_size == 0) {
+        throw invalid_argument("NearDuplicateOptions must have a non-empty signature"s);
+    }
+    // с ростом числа строк кандидатов меньше, поэтому берётся наибольшее, ещё дающее нужную вероятность;
+    // при одной строке на полосу вероятность 1 - (1 - threshold)^signature_size
+    for (size_t rows_per_band = options.signature_size; rows_per_band > 1; --rows_per_band) {
+        const size_t bands = options.signature_size / rows_per_band;
+        const double candidate_probability = 1.0 - pow(1.0 - pow(threshold, rows_per_band), bands);
+        if (candidate_probability >= options.min_candidate_probability) {
+            return {bands, rows_per_band};
+        }
+    }
+    return {options.signature_size, 1};
+}
+
+// Ключи полос сигнатуры MinHash документа. i-я хеш-функция h1 + i * h2 строится из двух
+// хешей слова, так что на слово приходится два перемешивания вместо bands * rows_per_band
+vector<uint64_t> ComputeBandKeys(const map<string_view, double>& word_freqs, size_t bands, size_t rows_per_band,
+                                 uint64_t seed) {
+    const size_t hash_count = bands * rows_per_band;
+    vector<uint64_t> signature(hash_count, numeric_limits<uint64_t>::max());
+    for (const auto& [word, _] : word_freqs) {
+        const uint64_t word_hash = ComputeWordFingerprint(word);
+        const uint64_t h1 = MixHash(word_hash ^ seed);
+        const uint64_t h2 = MixHash(h1 ^ word_hash) | 1;
+        uint64_t hash = h1;
+        for (uint64_t& min_hash : signature) {
+            min_hash = min(min_hash, hash);
+            hash += h2;
+        }
+    }
+
+    vector<uint64_t> band_keys(bands);
+    for (size_t band = 0; band < bands; ++band) {
+        uint64_t key = MixHash(seed + band);
+        for (size_t row = 0; row < rows_per_band; ++row) {
+            key = MixHash(key ^ signature[band * rows_per_band + row]);
+        }
+        band_keys[band] = key;
+    }
+    return band_keys;
+}
+
+// Хотя бы один из наборов не пуст
+double ComputeJaccardSimilarity(const map<string_view, double>& lhs, const map<string_view, double>& rhs) {
+    size_t common = 0;
+    auto lhs_it = lhs.begin();
+    auto rhs_it = rhs.begin();
+    while (lhs_it != lhs.end() && rhs_it != rhs.end()) {
+        if (lhs_it->first < rhs_it->first) {
+            ++lhs_it;
+        } else if (rhs_it->first < lhs_it->first) {
+            ++rhs_it;
+        } else {
+            ++common;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    return static_cast<double>(common) / (lhs.size() + rhs.size() - common);
+}
+
+}  // namespace
+
+vector<NearDuplicatePair> FindNearDuplicates(const SearchServer& search_server, double threshold,
+                                             const NearDuplicateOptions& options) {
+    if (!(threshold > 0.0 && threshold <= 1.0)) {
+        throw invalid_argument("Near duplicate threshold must be in (0, 1]"s);
+    }
+    const auto [bands, rows_per_band] = ChooseBands(threshold, options);
+    // документы без слов не похожи ни на какие, их сигнатуры не строятся
+    vector<int> document_ids;
+    for (const int document_id : search_server) {
+        if (!search_server.GetWordFrequencies(document_id).empty()) {
+            document_ids.push_back(document_id);
+        }
+    }
+    const size_t document_count = document_ids.size();
+
+    // ключи полос документа i лежат в band_keys[i * bands, (i + 1) * bands)
+    vector<uint64_t> band_keys(document_count * bands);
+    vector<size_t> indexes(document_count);
+    iota(indexes.begin(), indexes.end(), 0);
+    for_each(execution::par, indexes.begin(), indexes.end(),
+        [&](size_t index) {
+            const auto keys = ComputeBandKeys(search_server.GetWordFrequencies(document_ids[index]),
+                                              bands, rows_per_band, options.seed);
+            copy(keys.begin(), keys.end(), band_keys.begin() + index * bands);
+        });
+    // пара берётся только из первой полосы, в которой совпали ключи документов,
+    // так что кандидаты не повторяются и их память не растёт с числом полос
+    const auto is_first_shared_band = [&](size_t band, size_t lhs, size_t rhs) {
+        for (size_t earlier_band = 0; earlier_band < band; ++earlier_band) {
+            if (band_keys[lhs * bands + earlier_band] == band_keys[rhs * bands + earlier_band]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // пары-кандидаты как индексы в document_ids, меньший индекс первым
+    vector<pair<uint32_t, uint32_t>> candidates;
+    vector<pair<uint64_t, uint32_t>> buckets(document_count);
+    for (size_t band = 0; band < bands; ++band) {
+        for (size_t index = 0; index < document_count; ++index) {
+            buckets[index] = {band_keys[index * bands + band], static_cast<uint32_t>(index)};
+        }
+        sort(execution::par, buckets.begin(), buckets.end());
+        for (size_t begin = 0, end = 0; begin < document_count; begin = end) {
+            for (end = begin + 1; end < document_count && buckets[end].first == buckets[begin].first; ++end) {
+            }
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t j = i + 1; j < end; ++j) {
+                    if (is_first_shared_band(band, buckets[i].second, buckets[j].second)) {
+                        candidates.emplace_back(buckets[i].second, buckets[j].second);
+                    }
+                }
+            }
+        }
+    }
+    sort(execution::par, candidates.begin(), candidates.end());
+
+    vector<NearDuplicatePair> pairs(candidates.size());
+    transform(execution::par, candidates.begin(), candidates.end(), pairs.begin(),
+        [&](const pair<uint32_t, uint32_t>& candidate) {
+            const int first_id = document_ids[candidate.first];
+            const int second_id = document_ids[candidate.second];
+            return NearDuplicatePair{first_id, second_id,
+                ComputeJaccardSimilarity(search_server.GetWordFrequencies(first_id),
+                                         search_server.GetWordFrequencies(second_id))};
+        });
+    pairs.erase(remove_if(pairs.begin(), pairs.end(),
+        [threshold](const NearDuplicatePair& near_duplicate) {
+            return near_duplicate.similarity < threshold;
+        }), pairs.end());
+    return pairs;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "search_server.h"
+
+// Параметры поиска почти дубликатов. Сигнатура MinHash из bands * rows_per_band значений
+// делится на bands полос, документы с совпавшей полосой становятся кандидатами.
+// Пара со сходством Жаккара s становится кандидатом с вероятностью 1 - (1 - s^rows_per_band)^bands,
+// порог этой кривой примерно (1 / bands)^(1 / rows_per_band)
+struct NearDuplicateOptions {
+    // если bands или rows_per_band равны 0, оба подбираются по порогу сходства: наибольшее rows_per_band
+    // при bands = signature_size / rows_per_band, с которым пара со сходством, равным порогу,
+    // становится кандидатом с вероятностью не меньше min_candidate_probability
+    size_t bands = 0;
+    size_t rows_per_band = 0;
+    size_t signature_size = 128;
+    double min_candidate_probability = 0.95;
+    uint64_t seed = 0x6a09e667f3bcc908ULL;
+};
+
+struct NearDuplicatePair {
+    int first_id = 0;
+    int second_id = 0;
+    // сходство Жаккара наборов различных слов
+    double similarity = 0.0;
+};
+
+// Пары документов (first_id < second_id), сходство наборов слов которых не меньше threshold из (0, 1].
+// Пары отсортированы по first_id, затем по second_id. Каждая пара-кандидат проверяется точным
+// сходством Жаккара, поэтому ложных пар нет, а пропуск пары возможен с вероятностью, заданной options.
+// Корзины полос не урезаются: проверяются все пары документов корзины, так что группа из k одинаковых
+// документов даёт k * (k - 1) / 2 пар. Документы без слов (из одних стоп-слов) в пары не входят
+std::vector<NearDuplicatePair> FindNearDuplicates(const SearchServer& search_server, double threshold,
+                                                  const NearDuplicateOptions& options = {});
@@ -16,7 +16,7 @@ class Paginator {
         Paginator(It begin, It end, size_t page_size) 
         {
                 for(It i = begin; i < end; advance(i, page_size)) {
-                    if (distance(begin, end) <= page_size) {
+                    if (static_cast<size_t>(distance(begin, end)) <= page_size) {
                         paginated_.push_back({begin, end});
                         break;
                     }
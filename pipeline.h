@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Конвейер из трёх стадий. produce заполняет очередной элемент в вызывающем потоке и возвращает
+// false, когда элементы кончились; transform выполняется параллельно в worker_count потоках;
+// consume получает результаты в одном потоке строго в порядке produce.
+// В работе одновременно не больше max_in_flight элементов, это ограничивает память конвейера.
+// Если какая-то стадия бросила исключение на элементе, все элементы до него всё равно доходят
+// до consume, следующие отбрасываются, а исключение пробрасывается из RunOrderedPipeline
+template <typename Input, typename Output, typename Producer, typename Transformer, typename Consumer>
+void RunOrderedPipeline(Producer produce, Transformer transform, Consumer consume,
+                        size_t worker_count, size_t max_in_flight) {
+    const size_t NO_ERROR = std::numeric_limits<size_t>::max();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<size_t, Input>> inputs;
+    std::map<size_t, Output> outputs;
+    size_t produced_count = 0;
+    size_t in_flight = 0;
+    bool input_done = false;
+    // номер первого элемента, на котором случилась ошибка
+    size_t error_index = NO_ERROR;
+    std::exception_ptr error;
+
+    // вызывается под mutex
+    const auto fail = [&](size_t index, std::exception_ptr exception) {
+        if (index < error_index) {
+            error_index = index;
+            error = exception;
+        }
+        changed.notify_all();
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+        threads.emplace_back([&] {
+            std::unique_lock lock(mutex);
+            while (true) {
+                changed.wait(lock, [&] {
+                    return input_done || !inputs.empty();
+                });
+                if (inputs.empty()) {
+                    return;
+                }
+                auto [index, input] = std::move(inputs.front());
+                inputs.pop_front();
+                if (index > error_index) {
+                    --in_flight;
+                    changed.notify_all();
+                    continue;
+                }
+                lock.unlock();
+                try {
+                    Output output = transform(std::move(input));
+                    lock.lock();
+                    outputs.emplace(index, std::move(output));
+                    changed.notify_all();
+                } catch (...) {
+                    lock.lock();
+                    fail(index, std::current_exception());
+                }
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        std::unique_lock lock(mutex);
+        for (size_t next_index = 0;; ++next_index) {
+            changed.wait(lock, [&] {
+                return next_index >= error_index || outputs.count(next_index) > 0
+                    || (input_done && next_index == produced_count);
+            });
+            if (next_index >= error_index || outputs.count(next_index) == 0) {
+                return;
+            }
+            auto output = std::move(outputs.at(next_index));
+            outputs.erase(next_index);
+            lock.unlock();
+            try {
+                consume(std::move(output));
+                lock.lock();
+            } catch (...) {
+                lock.lock();
+                fail(next_index, std::current_exception());
+            }
+            --in_flight;
+            changed.notify_all();
+        }
+    });
+
+    while (true) {
+        {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [&] {
+                return error_index != NO_ERROR || in_flight < std::max<size_t>(max_in_flight, 1);
+            });
+            if (error_index != NO_ERROR) {
+                break;
+            }
+        }
+        Input input;
+        bool has_input = false;
+        try {
+            has_input = produce(input);
+        } catch (...) {
+            std::lock_guard guard(mutex);
+            fail(produced_count, std::current_exception());
+            break;
+        }
+        if (!has_input) {
+            break;
+        }
+        std::lock_guard guard(mutex);
+        inputs.emplace_back(produced_count++, std::move(input));
+        ++in_flight;
+        changed.notify_all();
+    }
+    {
+        std::lock_guard guard(mutex);
+        input_done = true;
+        changed.notify_all();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
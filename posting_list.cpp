@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <iterator>
+
+#include "posting_list.h"
+
+namespace {
+
+int GetBitWidth(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+void WriteBits(std::vector<uint64_t>& packed, uint64_t& bit_offset, uint64_t value, int bits) {
+    if (bits == 0) {
+        return;
+    }
+    const size_t word = bit_offset / 64;
+    const int shift = bit_offset % 64;
+    if (word + 1 >= packed.size()) {
+        packed.resize(word + 2, 0);
+    }
+    packed[word] |= value << shift;
+    if (shift + bits > 64) {
+        packed[word + 1] |= value >> (64 - shift);
+    }
+    bit_offset += bits;
+}
+
+uint64_t ReadBits(const std::vector<uint64_t>& packed, uint64_t bit_offset, int bits) {
+    const size_t word = bit_offset / 64;
+    const int shift = bit_offset % 64;
+    uint64_t value = packed[word] >> shift;
+    if (shift + bits > 64) {
+        value |= packed[word + 1] << (64 - shift);
+    }
+    return value & ((uint64_t{1} << bits) - 1);
+}
+
+// Первая позиция из [from, size), на которой less ложно, если less истинно на префиксе.
+// Граница ищется шагами 1, 2, 4, ... от from, а затем двоичным поиском внутри последнего шага
+template <typename T, typename Less>
+size_t GallopPartitionPoint(const T* values, size_t from, size_t size, Less less) {
+    size_t bound = from;
+    size_t step = 1;
+    while (bound < size && less(values[bound])) {
+        from = bound + 1;
+        bound += step;
+        step *= 2;
+    }
+    return std::partition_point(values + from, values + std::min(bound, size), less) - values;
+}
+
+}  // namespace
+
+    PostingList::PostingList(std::vector<int> document_ids, std::vector<double> term_freqs)
+        : document_ids_(std::move(document_ids))
+        , term_freqs_(std::move(term_freqs))
+    {
+        max_term_freq_ = term_freqs_.empty() ? 0.0 : *std::max_element(term_freqs_.begin(), term_freqs_.end());
+        UpdateRangeMaxima();
+    }
+
+    PostingList PostingList::FromData(const Data& data) {
+        PostingList postings;
+        postings.is_view_ = true;
+        postings.view_ = data;
+        postings.max_term_freq_ = data.max_term_freq;
+        postings.range_width_ = data.range_width;
+        return postings;
+    }
+
+    PostingList::Data PostingList::GetData() const {
+        if (is_view_) {
+            return view_;
+        }
+        return {document_ids_.data(), term_freqs_.data(), document_ids_.size(), max_term_freq_, range_width_,
+                range_maxima_.data(), range_maxima_.size()};
+    }
+
+    void PostingList::Add(int document_id, double term_freq) {
+        Decompress();
+        size_t index = document_ids_.size();
+        // документы обычно добавляются по возрастанию id, и слова одного документа идут подряд
+        if (document_ids_.empty() || document_ids_.back() < document_id) {
+            document_ids_.push_back(document_id);
+            term_freqs_.push_back(term_freq);
+        } else if (document_ids_.back() == document_id) {
+            --index;
+            term_freqs_[index] += term_freq;
+        } else {
+            index = LowerBound(document_id);
+            if (document_ids_[index] == document_id) {
+                term_freqs_[index] += term_freq;
+            } else {
+                document_ids_.insert(document_ids_.begin() + index, document_id);
+                term_freqs_.insert(term_freqs_.begin() + index, term_freq);
+            }
+        }
+        max_term_freq_ = std::max(max_term_freq_, term_freqs_[index]);
+
+        // частота только выросла, поэтому наибольшая частота диапазона не пересчитывается, а поднимается
+        if (range_width_ == 0) {
+            UpdateRangeMaxima();
+            return;
+        }
+        const int range = document_id / range_width_;
+        const auto it = FindRangeMax(range);
+        if (it != range_maxima_.end() && it->range == range) {
+            it->max_term_freq = std::max(it->max_term_freq, term_freqs_[index]);
+        } else {
+            range_maxima_.insert(it, {range, 0, term_freqs_[index]});
+        }
+        // диапазоны измельчились вдвое против подобранных - ширина подбирается заново
+        if (range_maxima_.size() * MIN_POSTINGS_PER_RANGE > 2 * size()) {
+            UpdateRangeMaxima();
+        }
+    }
+
+    bool PostingList::Remove(int document_id) {
+        if (!Contains(document_id)) {
+            return false;
+        }
+        Decompress();
+        const size_t index = LowerBound(document_id);
+        const double term_freq = term_freqs_[index];
+        document_ids_.erase(document_ids_.begin() + index);
+        term_freqs_.erase(term_freqs_.begin() + index);
+        if (term_freq >= max_term_freq_) {
+            max_term_freq_ = term_freqs_.empty() ? 0.0 : *std::max_element(term_freqs_.begin(), term_freqs_.end());
+        }
+
+        if (range_width_ == 0 || size() < MIN_SIZE_FOR_RANGE_MAXIMA) {
+            UpdateRangeMaxima();
+            return true;
+        }
+        // наибольшая частота диапазона пересчитывается по его оставшимся документам
+        const int range = document_id / range_width_;
+        const auto it = FindRangeMax(range);
+        const size_t range_begin = LowerBound(static_cast<int>(range * range_width_));
+        const size_t range_end = std::lower_bound(document_ids_.begin() + range_begin, document_ids_.end(),
+            (range + 1) * range_width_) - document_ids_.begin();
+        if (range_begin == range_end) {
+            range_maxima_.erase(it);
+        } else {
+            it->max_term_freq = *std::max_element(term_freqs_.begin() + range_begin, term_freqs_.begin() + range_end);
+        }
+        return true;
+    }
+
+    bool PostingList::Contains(int document_id) const {
+        if (blocks_.empty()) {
+            const Data data = GetData();
+            return std::binary_search(data.document_ids, data.document_ids + data.size, document_id);
+        }
+        bool found = false;
+        ForEachInRange(document_id, int64_t{document_id} + 1, [&found](int, double) {
+            found = true;
+        });
+        return found;
+    }
+
+    void PostingList::Compress() {
+        if (!blocks_.empty() || empty()) {
+            return;
+        }
+        Decompress();
+        freq_dictionary_ = term_freqs_;
+        std::sort(freq_dictionary_.begin(), freq_dictionary_.end());
+        freq_dictionary_.erase(std::unique(freq_dictionary_.begin(), freq_dictionary_.end()), freq_dictionary_.end());
+        freq_dictionary_.shrink_to_fit();
+        std::vector<uint32_t> freq_indexes(term_freqs_.size());
+        for (size_t i = 0; i < term_freqs_.size(); ++i) {
+            freq_indexes[i] = std::lower_bound(freq_dictionary_.begin(), freq_dictionary_.end(), term_freqs_[i])
+                - freq_dictionary_.begin();
+        }
+
+        uint64_t bit_offset = 0;
+        for (size_t begin = 0; begin < document_ids_.size(); begin += BLOCK_SIZE) {
+            const size_t end = std::min(begin + BLOCK_SIZE, document_ids_.size());
+            // первый id лежит в заголовке, в блок пишутся разности минус один и номера частот
+            uint64_t max_delta = 0;
+            uint32_t max_freq_index = 0;
+            for (size_t i = begin; i < end; ++i) {
+                if (i > begin) {
+                    max_delta = std::max<uint64_t>(max_delta, int64_t{document_ids_[i]} - document_ids_[i - 1] - 1);
+                }
+                max_freq_index = std::max(max_freq_index, freq_indexes[i]);
+            }
+            BlockHeader header{document_ids_[begin], document_ids_[end - 1], bit_offset,
+                               static_cast<uint8_t>(GetBitWidth(max_delta)),
+                               static_cast<uint8_t>(GetBitWidth(max_freq_index))};
+            for (size_t i = begin + 1; i < end; ++i) {
+                WriteBits(packed_, bit_offset, int64_t{document_ids_[i]} - document_ids_[i - 1] - 1, header.id_bits);
+            }
+            for (size_t i = begin; i < end; ++i) {
+                WriteBits(packed_, bit_offset, freq_indexes[i], header.freq_bits);
+            }
+            blocks_.push_back(header);
+        }
+        // запас в одно слово позволяет читать два слова подряд без проверки границы
+        packed_.resize(bit_offset / 64 + 2, 0);
+        packed_.shrink_to_fit();
+        blocks_.shrink_to_fit();
+
+        compressed_size_ = document_ids_.size();
+        std::vector<int>().swap(document_ids_);
+        std::vector<double>().swap(term_freqs_);
+    }
+
+    double PostingList::GetMaxTermFreq() const {
+        return max_term_freq_;
+    }
+
+    bool PostingList::IsCompressed() const {
+        return !blocks_.empty();
+    }
+
+    size_t PostingList::size() const {
+        if (!blocks_.empty()) {
+            return compressed_size_;
+        }
+        return is_view_ ? view_.size : document_ids_.size();
+    }
+
+    bool PostingList::empty() const {
+        return size() == 0;
+    }
+
+    size_t PostingList::GetMemoryUsage() const {
+        return document_ids_.capacity() * sizeof(int) + term_freqs_.capacity() * sizeof(double)
+            + blocks_.capacity() * sizeof(BlockHeader) + packed_.capacity() * sizeof(uint64_t)
+            + freq_dictionary_.capacity() * sizeof(double) + range_maxima_.capacity() * sizeof(RangeMax);
+    }
+
+    std::vector<int> PostingList::SampleDocumentIds(size_t step) const {
+        std::vector<int> sampled;
+        if (blocks_.empty()) {
+            const Data data = GetData();
+            for (size_t position = step; position < data.size; position += step) {
+                sampled.push_back(data.document_ids[position]);
+            }
+            return sampled;
+        }
+        int document_ids[BLOCK_SIZE];
+        double term_freqs[BLOCK_SIZE];
+        size_t decoded_block = blocks_.size();
+        for (size_t position = step; position < compressed_size_; position += step) {
+            const size_t block = position / BLOCK_SIZE;
+            if (block != decoded_block) {
+                DecodeBlock(block, document_ids, term_freqs);
+                decoded_block = block;
+            }
+            sampled.push_back(document_ids[position % BLOCK_SIZE]);
+        }
+        return sampled;
+    }
+
+    std::vector<int> PostingList::GetDocumentIds() const {
+        std::vector<int> document_ids;
+        document_ids.reserve(size());
+        ForEach([&document_ids](int document_id, double) {
+            document_ids.push_back(document_id);
+        });
+        return document_ids;
+    }
+
+    std::vector<double> PostingList::GetTermFreqs() const {
+        std::vector<double> term_freqs;
+        term_freqs.reserve(size());
+        ForEach([&term_freqs](int, double term_freq) {
+            term_freqs.push_back(term_freq);
+        });
+        return term_freqs;
+    }
+
+    PostingList::Cursor::Cursor(const PostingList& postings)
+        : postings_(&postings)
+        , compressed_(postings.IsCompressed())
+        , data_(postings.GetData())
+    {
+        if (compressed_) {
+            LoadBlock(0);
+        } else {
+            segment_size_ = data_.size;
+        }
+    }
+
+    bool PostingList::Cursor::AtEnd() const {
+        return position_ == segment_size_;
+    }
+
+    int PostingList::Cursor::GetDocumentId() const {
+        return GetSegmentDocumentIds()[position_];
+    }
+
+    double PostingList::Cursor::GetTermFreq() const {
+        return compressed_ ? block_term_freqs_[position_] : data_.term_freqs[position_];
+    }
+
+    void PostingList::Cursor::Next() {
+        ++position_;
+        if (compressed_ && position_ == segment_size_) {
+            LoadBlock(next_block_);
+        }
+    }
+
+    bool PostingList::Cursor::SkipTo(int document_id) {
+        if (AtEnd()) {
+            return false;
+        }
+        if (compressed_ && postings_->blocks_[next_block_ - 1].last_document_id < document_id) {
+            const auto& blocks = postings_->blocks_;
+            LoadBlock(GallopPartitionPoint(blocks.data(), next_block_, blocks.size(),
+                [document_id](const BlockHeader& header) {
+                    return header.last_document_id < document_id;
+                }));
+            if (AtEnd()) {
+                return false;
+            }
+        }
+        const int* document_ids = GetSegmentDocumentIds();
+        position_ = GallopPartitionPoint(document_ids, position_, segment_size_,
+            [document_id](int current_document_id) {
+                return current_document_id < document_id;
+            });
+        return !AtEnd() && document_ids[position_] == document_id;
+    }
+
+    double PostingList::Cursor::GetRangeMaxTermFreq(int document_id) {
+        const RangeMax* range_maxima = data_.range_maxima;
+        if (data_.range_count == 0) {
+            return data_.max_term_freq;
+        }
+        const int range = document_id / data_.range_width;
+        range_position_ = GallopPartitionPoint(range_maxima, range_position_, data_.range_count,
+            [range](const RangeMax& range_max) {
+                return range_max.range < range;
+            });
+        return range_position_ < data_.range_count && range_maxima[range_position_].range == range
+            ? range_maxima[range_position_].max_term_freq
+            : 0.0;
+    }
+
+    int64_t PostingList::Cursor::GetRangeEnd(int document_id) const {
+        const int64_t range_width = data_.range_width;
+        return range_width == 0 ? INT64_MAX : (document_id / range_width + 1) * range_width;
+    }
+
+    const int* PostingList::Cursor::GetSegmentDocumentIds() const {
+        return compressed_ ? block_document_ids_ : data_.document_ids;
+    }
+
+    void PostingList::Cursor::LoadBlock(size_t block) {
+        position_ = 0;
+        next_block_ = block + 1;
+        segment_size_ = block < postings_->blocks_.size()
+            ? postings_->DecodeBlock(block, block_document_ids_, block_term_freqs_)
+            : 0;
+    }
+
+    size_t PostingList::LowerBound(int document_id) const {
+        const Data data = GetData();
+        return std::lower_bound(data.document_ids, data.document_ids + data.size, document_id) - data.document_ids;
+    }
+
+    void PostingList::UpdateRangeMaxima() {
+        if (size() < MIN_SIZE_FOR_RANGE_MAXIMA) {
+            range_width_ = 0;
+            std::vector<RangeMax>().swap(range_maxima_);
+            return;
+        }
+        const int64_t first_document_id = blocks_.empty() ? document_ids_.front() : blocks_.front().first_document_id;
+        const int64_t last_document_id = blocks_.empty() ? document_ids_.back() : blocks_.back().last_document_id;
+        const int64_t min_range_width = (last_document_id - first_document_id + 1) * MIN_POSTINGS_PER_RANGE / size();
+        range_width_ = 1;
+        while (range_width_ < min_range_width) {
+            range_width_ *= 2;
+        }
+        range_maxima_.clear();
+        ForEach([this](int document_id, double term_freq) {
+            const int range = document_id / range_width_;
+            if (range_maxima_.empty() || range_maxima_.back().range != range) {
+                range_maxima_.push_back({range, 0, term_freq});
+            } else {
+                range_maxima_.back().max_term_freq = std::max(range_maxima_.back().max_term_freq, term_freq);
+            }
+        });
+    }
+
+    std::vector<PostingList::RangeMax>::iterator PostingList::FindRangeMax(int range) {
+        return std::partition_point(range_maxima_.begin(), range_maxima_.end(),
+            [range](const RangeMax& range_max) {
+                return range_max.range < range;
+            });
+    }
+
+    void PostingList::Decompress() {
+        if (is_view_) {
+            document_ids_.assign(view_.document_ids, view_.document_ids + view_.size);
+            term_freqs_.assign(view_.term_freqs, view_.term_freqs + view_.size);
+            range_maxima_.assign(view_.range_maxima, view_.range_maxima + view_.range_count);
+            is_view_ = false;
+            view_ = Data();
+            return;
+        }
+        if (blocks_.empty()) {
+            return;
+        }
+        std::vector<int> document_ids = GetDocumentIds();
+        std::vector<double> term_freqs = GetTermFreqs();
+        document_ids_ = std::move(document_ids);
+        term_freqs_ = std::move(term_freqs);
+        compressed_size_ = 0;
+        std::vector<BlockHeader>().swap(blocks_);
+        std::vector<uint64_t>().swap(packed_);
+        std::vector<double>().swap(freq_dictionary_);
+    }
+
+    size_t PostingList::FindBlock(int64_t document_id) const {
+        return std::partition_point(blocks_.begin(), blocks_.end(),
+            [document_id](const BlockHeader& header) {
+                return header.last_document_id < document_id;
+            }) - blocks_.begin();
+    }
+
+    size_t PostingList::DecodeBlock(size_t block, int* document_ids, double* term_freqs) const {
+        const BlockHeader& header = blocks_[block];
+        const size_t block_size = std::min(BLOCK_SIZE, compressed_size_ - block * BLOCK_SIZE);
+        uint64_t bit_offset = header.bit_offset;
+        int document_id = header.first_document_id;
+        document_ids[0] = document_id;
+        for (size_t i = 1; i < block_size; ++i, bit_offset += header.id_bits) {
+            document_id += static_cast<int>(header.id_bits == 0 ? 0 : ReadBits(packed_, bit_offset, header.id_bits)) + 1;
+            document_ids[i] = document_id;
+        }
+        for (size_t i = 0; i < block_size; ++i, bit_offset += header.freq_bits) {
+            term_freqs[i] = freq_dictionary_[header.freq_bits == 0 ? 0 : ReadBits(packed_, bit_offset, header.freq_bits)];
+        }
+        return block_size;
+    }
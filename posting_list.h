@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Список вхождений слова: id документов по возрастанию и частоты слова в них.
+// Несжатый список хранит два непрерывных массива, чтобы обход шёл по памяти подряд.
+// Compress переводит список в блоки по BLOCK_SIZE вхождений: разности соседних id
+// и номера частот в словаре частот списка упакованы побитово минимальной для блока
+// шириной, а заголовки блоков хранят первый и последний id, чтобы пропускать блоки не распаковывая.
+// Частота документа - сумма одинаковых слагаемых 1 / число слов документа, поэтому разных частот
+// в списке мало и словарь частот сжимает их без потерь
+class PostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+    // Для списков не короче MIN_SIZE_FOR_RANGE_MAXIMA хранится наибольшая частота в каждом диапазоне
+    // id [k * w, (k + 1) * w), где есть документы списка. Ширина w - степень двойки, при которой
+    // в диапазоне в среднем не меньше MIN_POSTINGS_PER_RANGE документов, так что оценки занимают
+    // доли байта на документ
+    static constexpr size_t MIN_SIZE_FOR_RANGE_MAXIMA = 128;
+    static constexpr size_t MIN_POSTINGS_PER_RANGE = 32;
+
+    // Наибольшая частота слова в диапазоне id [range * w, (range + 1) * w), где w - ширина диапазонов списка
+    struct RangeMax {
+        // номер диапазона, document_id / w
+        int32_t range;
+        // всегда 0: поле занимает место выравнивания, чтобы в снимок индекса не попадали случайные байты
+        int32_t reserved;
+        double max_term_freq;
+    };
+
+    // Несжатые вхождения и наибольшие частоты по диапазонам - всё, из чего FromData восстанавливает список
+    struct Data {
+        const int* document_ids = nullptr;
+        const double* term_freqs = nullptr;
+        size_t size = 0;
+        double max_term_freq = 0.0;
+        // 0 - диапазонов нет
+        int64_t range_width = 0;
+        const RangeMax* range_maxima = nullptr;
+        size_t range_count = 0;
+    };
+
+    PostingList() = default;
+
+    // Массивы должны быть одного размера, id - строго по возрастанию
+    PostingList(std::vector<int> document_ids, std::vector<double> term_freqs);
+
+    // Список поверх чужих массивов, например в отображённом в память снимке индекса: вхождения
+    // не копируются, поэтому массивы должны пережить и сам список, и его копии. Add, Remove и Compress
+    // сначала копируют вхождения в собственную память
+    static PostingList FromData(const Data& data);
+
+    // У сжатого списка в Data только наибольшие частоты, без вхождений.
+    // Указатели действительны, пока список не меняется
+    Data GetData() const;
+
+    // Прибавляет term_freq к частоте слова в документе, добавляя документ при необходимости.
+    // Сжатый список сначала распаковывается
+    void Add(int document_id, double term_freq);
+
+    // Возвращает false, если документа в списке не было. Сжатый список сначала распаковывается
+    bool Remove(int document_id);
+
+    bool Contains(int document_id) const;
+
+    void Compress();
+
+    bool IsCompressed() const;
+
+    // Наибольшая частота слова в документах списка - верхняя оценка вклада слова в релевантность
+    double GetMaxTermFreq() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    // Собственная память под вхождения без учёта самого объекта; чужие массивы списка из FromData не входят
+    size_t GetMemoryUsage() const;
+
+    // Вызывает visitor(document_id, term_freq) для документов с id из [lower, upper)
+    // по возрастанию id и возвращает их число
+    template <typename Visitor>
+    size_t ForEachInRange(int64_t lower, int64_t upper, Visitor visitor) const;
+
+    template <typename Visitor>
+    size_t ForEach(Visitor visitor) const;
+
+    // Курсор по списку в порядке возрастания id. SkipTo идёт вперёд галопом: шаг удваивается, пока
+    // не перескочит цель, затем двоичный поиск, так что p переходов по списку длины m стоят O(p log(m / p)).
+    // В сжатом списке галопом пропускаются заголовки блоков и распаковывается только блок с целью.
+    // Список не должен меняться, пока по нему идёт курсор
+    class Cursor {
+    public:
+        explicit Cursor(const PostingList& postings);
+
+        bool AtEnd() const;
+
+        // Только для курсора не в конце
+        int GetDocumentId() const;
+
+        double GetTermFreq() const;
+
+        void Next();
+
+        // Переходит к первому документу с id не меньше document_id; назад курсор не двигается.
+        // Возвращает true, если курсор встал ровно на document_id
+        bool SkipTo(int document_id);
+
+        // Наибольшая частота слова в документах диапазона document_id, у коротких списков - во всём списке.
+        // document_id от вызова к вызову не должен убывать
+        double GetRangeMaxTermFreq(int document_id);
+
+        // Первый id после диапазона document_id; у коротких списков диапазон - все id
+        int64_t GetRangeEnd(int document_id) const;
+
+    private:
+        const PostingList* postings_;
+        bool compressed_;
+        Data data_;
+        // текущий отрезок - весь несжатый список или распакованный блок сжатого
+        size_t segment_size_ = 0;
+        size_t position_ = 0;
+        size_t next_block_ = 0;
+        size_t range_position_ = 0;
+        int block_document_ids_[BLOCK_SIZE];
+        double block_term_freqs_[BLOCK_SIZE];
+
+        const int* GetSegmentDocumentIds() const;
+
+        void LoadBlock(size_t block);
+    };
+
+    // id документов на позициях step, 2 * step, ...
+    std::vector<int> SampleDocumentIds(size_t step) const;
+
+    std::vector<int> GetDocumentIds() const;
+
+    std::vector<double> GetTermFreqs() const;
+
+private:
+    struct BlockHeader {
+        int first_document_id;
+        int last_document_id;
+        // начало блока в packed_, в битах
+        uint64_t bit_offset;
+        uint8_t id_bits;
+        uint8_t freq_bits;
+    };
+
+    // несжатое представление
+    std::vector<int> document_ids_;
+    std::vector<double> term_freqs_;
+
+    // список поверх чужих массивов (см. FromData); собственные document_ids_, term_freqs_ и range_maxima_ у него пусты
+    bool is_view_ = false;
+    Data view_;
+
+    // сжатое представление
+    size_t compressed_size_ = 0;
+    std::vector<BlockHeader> blocks_;
+    std::vector<uint64_t> packed_;
+    // различные частоты списка по возрастанию
+    std::vector<double> freq_dictionary_;
+
+    double max_term_freq_ = 0.0;
+    // 0 у списков короче MIN_SIZE_FOR_RANGE_MAXIMA, у них нет и range_maxima_
+    int64_t range_width_ = 0;
+    // по возрастанию диапазонов
+    std::vector<RangeMax> range_maxima_;
+
+    size_t LowerBound(int document_id) const;
+
+    // Подбирает ширину диапазонов и строит range_maxima_ заново или очищает их у короткого списка
+    void UpdateRangeMaxima();
+
+    std::vector<RangeMax>::iterator FindRangeMax(int range);
+
+    // Переводит сжатый список или список поверх чужих массивов в несжатый в собственной памяти
+    void Decompress();
+
+    // Первый блок, последний id которого не меньше document_id
+    size_t FindBlock(int64_t document_id) const;
+
+    // Распаковывает блок в document_ids и term_freqs (по BLOCK_SIZE элементов) и возвращает его размер
+    size_t DecodeBlock(size_t block, int* document_ids, double* term_freqs) const;
+};
+
+template <typename Visitor>
+    size_t PostingList::ForEachInRange(int64_t lower, int64_t upper, Visitor visitor) const {
+        size_t visited = 0;
+        if (blocks_.empty()) {
+            const Data data = GetData();
+            for (size_t i = LowerBound(static_cast<int>(std::max<int64_t>(lower, INT32_MIN)));
+                 i < data.size && data.document_ids[i] < upper; ++i, ++visited) {
+                visitor(data.document_ids[i], data.term_freqs[i]);
+            }
+            return visited;
+        }
+
+        int document_ids[BLOCK_SIZE];
+        double term_freqs[BLOCK_SIZE];
+        for (size_t block = FindBlock(lower); block < blocks_.size() && blocks_[block].first_document_id < upper; ++block) {
+            const size_t block_size = DecodeBlock(block, document_ids, term_freqs);
+            for (size_t i = 0; i < block_size; ++i) {
+                if (document_ids[i] < lower) {
+                    continue;
+                }
+                if (document_ids[i] >= upper) {
+                    return visited;
+                }
+                visitor(document_ids[i], term_freqs[i]);
+                ++visited;
+            }
+        }
+        return visited;
+    }
+
+template <typename Visitor>
+    size_t PostingList::ForEach(Visitor visitor) const {
+        return ForEachInRange(INT64_MIN, INT64_MAX, visitor);
+    }
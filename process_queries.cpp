@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <execution>
+
+#include "process_queries.h"
+
+    JoinedQueryResults::Iterator::Iterator(const std::vector<std::vector<Document>>* results,
+                                           size_t query_index, size_t document_index)
+        : results_(results)
+        , query_index_(query_index)
+        , document_index_(document_index)
+    {
+        SkipEmptyQueries();
+    }
+
+    JoinedQueryResults::Iterator::reference JoinedQueryResults::Iterator::operator*() const {
+        return (*results_)[query_index_][document_index_];
+    }
+
+    JoinedQueryResults::Iterator::pointer JoinedQueryResults::Iterator::operator->() const {
+        return &**this;
+    }
+
+    JoinedQueryResults::Iterator& JoinedQueryResults::Iterator::operator++() {
+        ++document_index_;
+        SkipEmptyQueries();
+        return *this;
+    }
+
+    JoinedQueryResults::Iterator JoinedQueryResults::Iterator::operator++(int) {
+        Iterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    bool JoinedQueryResults::Iterator::operator==(const Iterator& other) const {
+        return query_index_ == other.query_index_ && document_index_ == other.document_index_;
+    }
+
+    bool JoinedQueryResults::Iterator::operator!=(const Iterator& other) const {
+        return !(*this == other);
+    }
+
+    void JoinedQueryResults::Iterator::SkipEmptyQueries() {
+        while (query_index_ < results_->size() && document_index_ == (*results_)[query_index_].size()) {
+            ++query_index_;
+            document_index_ = 0;
+        }
+    }
+
+    JoinedQueryResults::JoinedQueryResults(std::vector<std::vector<Document>> results)
+        : results_(std::move(results))
+    {
+        for (const auto& documents : results_) {
+            size_ += documents.size();
+        }
+    }
+
+    JoinedQueryResults::Iterator JoinedQueryResults::begin() const {
+        return Iterator(&results_, 0, 0);
+    }
+
+    JoinedQueryResults::Iterator JoinedQueryResults::end() const {
+        return Iterator(&results_, results_.size(), 0);
+    }
+
+    size_t JoinedQueryResults::size() const {
+        return size_;
+    }
+
+    bool JoinedQueryResults::empty() const {
+        return size_ == 0;
+    }
+
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    std::vector<std::vector<Document>> results(queries.size());
+    std::transform(std::execution::par, queries.begin(), queries.end(), results.begin(),
+        [&search_server](const std::string& query) {
+            return search_server.FindTopDocuments(query);
+        });
+    return results;
+}
+
+JoinedQueryResults ProcessQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    return JoinedQueryResults(ProcessQueries(search_server, queries));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Результаты пачки запросов, которые обходятся как одна последовательность документов
+// без копирования в общий вектор
+class JoinedQueryResults {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator(const std::vector<std::vector<Document>>* results, size_t query_index, size_t document_index);
+
+        reference operator*() const;
+
+        pointer operator->() const;
+
+        Iterator& operator++();
+
+        Iterator operator++(int);
+
+        bool operator==(const Iterator& other) const;
+
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        const std::vector<std::vector<Document>>* results_;
+        size_t query_index_;
+        size_t document_index_;
+
+        void SkipEmptyQueries();
+    };
+
+    explicit JoinedQueryResults(std::vector<std::vector<Document>> results);
+
+    Iterator begin() const;
+
+    Iterator end() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+private:
+    std::vector<std::vector<Document>> results_;
+    size_t size_ = 0;
+};
+
+// Выполняет запросы параллельно, i-й элемент результата - выдача FindTopDocuments для queries[i]
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// То же, но выдачи всех запросов идут подряд в порядке запросов
+JoinedQueryResults ProcessQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
@@ -0,0 +1,66 @@
+#include "query_cache.h"
+
+    QueryResultCache::QueryResultCache(size_t memory_budget)
+        : memory_budget_(memory_budget)
+    {
+        stats_.memory_budget = memory_budget;
+    }
+
+    std::optional<std::vector<Document>> QueryResultCache::Find(std::string_view key, uint64_t epoch) {
+        std::lock_guard guard(mutex_);
+        SetEpoch(epoch);
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            ++stats_.misses;
+            return std::nullopt;
+        }
+        ++stats_.hits;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->documents;
+    }
+
+    void QueryResultCache::Insert(std::string key, std::vector<Document> documents, uint64_t epoch) {
+        // ключ, вектор, узел списка и узел хеш-таблицы с запасом на служебные поля
+        const size_t memory_usage = sizeof(Entry) + key.capacity() + documents.capacity() * sizeof(Document)
+            + 2 * sizeof(void*) + sizeof(std::string_view) + 4 * sizeof(void*);
+        if (memory_usage > memory_budget_) {
+            return;
+        }
+
+        std::lock_guard guard(mutex_);
+        SetEpoch(epoch);
+        if (index_.count(key) > 0) {
+            return;
+        }
+        while (stats_.memory_usage + memory_usage > memory_budget_) {
+            index_.erase(entries_.back().key);
+            stats_.memory_usage -= entries_.back().memory_usage;
+            entries_.pop_back();
+            ++stats_.evictions;
+        }
+        entries_.push_front({std::move(key), std::move(documents), memory_usage});
+        index_.emplace(entries_.front().key, entries_.begin());
+        stats_.memory_usage += memory_usage;
+    }
+
+    QueryCacheStats QueryResultCache::GetStats() const {
+        std::lock_guard guard(mutex_);
+        QueryCacheStats stats = stats_;
+        stats.entries = entries_.size();
+        return stats;
+    }
+
+    size_t QueryResultCache::GetMemoryBudget() const {
+        return memory_budget_;
+    }
+
+    void QueryResultCache::SetEpoch(uint64_t epoch) {
+        if (epoch == epoch_) {
+            return;
+        }
+        epoch_ = epoch;
+        stats_.invalidations += entries_.size();
+        stats_.memory_usage = 0;
+        index_.clear();
+        entries_.clear();
+    }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+struct QueryCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    // вытеснено по бюджету памяти
+    size_t evictions = 0;
+    // сброшено из-за изменения индекса
+    size_t invalidations = 0;
+    size_t entries = 0;
+    size_t memory_usage = 0;
+    size_t memory_budget = 0;
+};
+
+// Потокобезопасный LRU-кеш выдач поисковых запросов с ограничением по памяти.
+// Каждая операция передаёт эпоху индекса; при смене эпохи все записи сбрасываются
+class QueryResultCache {
+public:
+    explicit QueryResultCache(size_t memory_budget);
+
+    std::optional<std::vector<Document>> Find(std::string_view key, uint64_t epoch);
+
+    // Запись больше всего бюджета не сохраняется
+    void Insert(std::string key, std::vector<Document> documents, uint64_t epoch);
+
+    QueryCacheStats GetStats() const;
+
+    size_t GetMemoryBudget() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+        size_t memory_usage;
+    };
+
+    const size_t memory_budget_;
+    mutable std::mutex mutex_;
+    uint64_t epoch_ = 0;
+    // в начале - последние использованные записи
+    std::list<Entry> entries_;
+    // ключи ссылаются на строки в entries_, узлы списка не перемещаются
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    QueryCacheStats stats_;
+
+    void SetEpoch(uint64_t epoch);
+};
@@ -1,7 +1,11 @@
 #include <iostream>
+#include <stdexcept>
+#include <string_view>
 
 #include "read_input_functions.h"
 
+using namespace std::string_literals;
+
 std::string ReadLine() {
     std::string s;
     getline(std::cin, s);
@@ -13,4 +17,74 @@ int ReadLineWithNumber() {
     std::cin >> result;
     ReadLine();
     return result;
-}
\ No newline at end of file
+}
+
+namespace {
+
+DocumentStatus ParseDocumentStatus(std::string_view text) {
+    if (text == "ACTUAL") {
+        return DocumentStatus::ACTUAL;
+    }
+    if (text == "IRRELEVANT") {
+        return DocumentStatus::IRRELEVANT;
+    }
+    if (text == "BANNED") {
+        return DocumentStatus::BANNED;
+    }
+    if (text == "REMOVED") {
+        return DocumentStatus::REMOVED;
+    }
+    throw std::invalid_argument("Unknown document status "s + std::string(text));
+}
+
+// Отрезает от line поле до табуляции
+std::string_view TakeField(std::string_view& line) {
+    const size_t tab = line.find('\t');
+    if (tab == std::string_view::npos) {
+        throw std::invalid_argument("Document line has too few fields"s);
+    }
+    const std::string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+int ParseInt(std::string_view text) {
+    size_t parsed_size = 0;
+    const std::string number(text);
+    int value = 0;
+    try {
+        value = std::stoi(number, &parsed_size);
+    } catch (const std::logic_error&) {
+        parsed_size = 0;
+    }
+    if (number.empty() || parsed_size != number.size()) {
+        throw std::invalid_argument("Invalid number "s + number);
+    }
+    return value;
+}
+
+}
+
+bool ReadDocumentRecord(std::istream& input, DocumentRecord& record) {
+    std::string line;
+    do {
+        if (!getline(input, line)) {
+            return false;
+        }
+    } while (line.empty());
+
+    std::string_view rest = line;
+    record.id = ParseInt(TakeField(rest));
+    record.status = ParseDocumentStatus(TakeField(rest));
+    record.ratings.clear();
+    std::string_view ratings = TakeField(rest);
+    while (!ratings.empty()) {
+        const size_t space = ratings.find(' ');
+        if (space != 0) {
+            record.ratings.push_back(ParseInt(ratings.substr(0, space)));
+        }
+        ratings.remove_prefix(space == std::string_view::npos ? ratings.size() : space + 1);
+    }
+    record.text.assign(rest);
+    return true;
+}
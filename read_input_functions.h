@@ -1,7 +1,15 @@
 #pragma once
 
+#include <istream>
 #include <string>
 
+#include "document.h"
+
 std::string ReadLine();
 
-int ReadLineWithNumber();
\ No newline at end of file
+int ReadLineWithNumber();
+
+// Читает документ из строки вида "id<TAB>статус<TAB>рейтинги через пробел<TAB>текст",
+// статус - ACTUAL, IRRELEVANT, BANNED или REMOVED. Пустые строки пропускаются.
+// Возвращает false в конце потока, для некорректной строки бросает std::invalid_argument
+bool ReadDocumentRecord(std::istream& input, DocumentRecord& record);
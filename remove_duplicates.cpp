@@ -1,27 +1,47 @@
-#include <set>
-#include <string>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include "search_server.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "remove_duplicates.h"
 
 using namespace std;
-//Вам нужно знать только, что нет дублей, а для этого достаточно проверить,
-//что ранее не была добавлена копия документа. Для этого подойдет контейнер set<set<string>>
 
-void RemoveDuplicates(SearchServer& search_server) {
-    set<int> duplicates;
-    set<set<string_view>> docs;
-    for (auto i = search_server.begin(); i != search_server.end(); ++i) {
-        const auto &doc = search_server.GetWordFrequencies(*i);
-        set<string_view> doc_words;
-
-        for (const auto &[word, freq]: doc) {
-            doc_words.insert(word);
-        }
-        if (docs.count(doc_words)) {
-            duplicates.insert(*i);
-        }
-        else {
-            docs.insert(doc_words);
+namespace {
+
+bool HaveSameWords(const SearchServer& search_server, int lhs_id, int rhs_id) {
+    const auto& lhs = search_server.GetWordFrequencies(lhs_id);
+    const auto& rhs = search_server.GetWordFrequencies(rhs_id);
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const auto& lhs_word, const auto& rhs_word) {
+            return lhs_word.first == rhs_word.first;
+        });
+}
+
+template <typename ExecutionPolicy>
+void RemoveDuplicatesImpl(ExecutionPolicy&& policy, SearchServer& search_server) {
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    vector<uint64_t> fingerprints(document_ids.size());
+    transform(policy, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+        [&search_server](int document_id) {
+            return search_server.GetDocumentFingerprint(document_id);
+        });
+
+    // оригиналы с одинаковым отпечатком; при коллизии их несколько
+    unordered_map<uint64_t, vector<int>> originals;
+    vector<int> duplicates;
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        auto& candidates = originals[fingerprints[i]];
+        const bool is_duplicate = any_of(candidates.begin(), candidates.end(),
+            [&](int original_id) {
+                return HaveSameWords(search_server, original_id, document_ids[i]);
+            });
+        if (is_duplicate) {
+            duplicates.push_back(document_ids[i]);
+        } else {
+            candidates.push_back(document_ids[i]);
         }
     }
     for (int id : duplicates) {
@@ -29,3 +49,17 @@ void RemoveDuplicates(SearchServer& search_server) {
         cout << "Found duplicate document id "s << id << endl;
     }
 }
+
+}  // namespace
+
+void RemoveDuplicates(SearchServer& search_server) {
+    RemoveDuplicatesImpl(execution::seq, search_server);
+}
+
+void RemoveDuplicates(const execution::sequenced_policy&, SearchServer& search_server) {
+    RemoveDuplicatesImpl(execution::seq, search_server);
+}
+
+void RemoveDuplicates(const execution::parallel_policy&, SearchServer& search_server) {
+    RemoveDuplicatesImpl(execution::par, search_server);
+}
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <execution>
+
 #include "search_server.h"
 
- void RemoveDuplicates(SearchServer& search_server);
- 
\ No newline at end of file
+// Удаляет документы, набор слов которых совпадает с набором слов документа с меньшим id.
+// Документы группируются по отпечаткам наборов слов, совпавшие наборы сверяются целиком
+void RemoveDuplicates(SearchServer& search_server);
+
+void RemoveDuplicates(const std::execution::sequenced_policy&, SearchServer& search_server);
+
+// Отпечатки документов считаются параллельно
+void RemoveDuplicates(const std::execution::parallel_policy&, SearchServer& search_server);
@@ -1,32 +1,112 @@
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+
 #include "request_queue.h"
 
-RequestQueue::RequestQueue(const SearchServer& search_server) : search_server_(search_server)
-        , no_results_requests_(0)
-        , current_time_(0) {
+using namespace std::chrono_literals;
+
+RequestQueue::RequestQueue(const SearchServer& search_server) : RequestQueue(search_server, Clock::now) {
+    }
+
+    RequestQueue::RequestQueue(const SearchServer& search_server, TimeSource now) : search_server_(search_server)
+        , now_(std::move(now))
+        , start_time_(now_()) {
+        // минута по секундам, час по минутам, сутки по часам
+        const std::array<std::pair<Clock::duration, size_t>, WINDOW_COUNT> layouts = {{
+            {1s, 60}, {1min, 60}, {1h, 24},
+        }};
+        for (Stripe& stripe : stripes_) {
+            for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+                stripe.windows[i].bucket_duration = layouts[i].first;
+                stripe.windows[i].buckets.resize(layouts[i].second);
+                stripe.windows[i].slice_duration = layouts[i].first * (layouts[i].second / LATENCY_SLICE_COUNT);
+            }
+        }
     }
     
-    std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-        return RequestQueue::AddFindRequest(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-                return document_status == status;
-            });
+    std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentStatus status) {
+        return RecordRequest([&] {
+            return search_server_.FindTopDocuments(raw_query, status);
+        });
     }
-    std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
+    std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query) {
         return RequestQueue::AddFindRequest(raw_query, DocumentStatus::ACTUAL);
     }
     int RequestQueue::GetNoResultRequests() const {
-        return no_results_requests_;
+        return GetStatistics(StatisticsWindow::DAY).no_result_requests;
     }
 
-    void RequestQueue::AddRequest(int results_num) {
-        ++current_time_;
-        while (!requests_.empty() && min_in_day_ <= current_time_ - requests_.front().timestamp) {
-            if (0 == requests_.front().results) {
-                --no_results_requests_;
+    RequestStatistics RequestQueue::GetStatistics(StatisticsWindow window) const {
+        const auto elapsed = now_() - start_time_;
+        // у всех полос одинаковое устройство окон
+        const SlidingWindow& layout = stripes_.front().windows[static_cast<size_t>(window)];
+        const Clock::duration bucket_duration = layout.bucket_duration;
+        const size_t bucket_count = layout.buckets.size();
+        const int64_t current_interval = elapsed / bucket_duration;
+        const int64_t oldest_interval = current_interval - static_cast<int64_t>(bucket_count) + 1;
+        const int64_t current_slice = elapsed / layout.slice_duration;
+        const int64_t oldest_slice = current_slice - static_cast<int64_t>(LATENCY_SLICE_COUNT);
+        // окно охватывает полные прошедшие корзины и начало текущей
+        const Clock::duration covered = std::min<Clock::duration>(elapsed,
+            bucket_duration * (bucket_count - 1) + elapsed % bucket_duration);
+
+        RequestStatistics statistics;
+        LatencyHistogram latencies;
+        for (const Stripe& stripe : stripes_) {
+            std::lock_guard guard(stripe.mutex);
+            const SlidingWindow& stripe_window = stripe.windows[static_cast<size_t>(window)];
+            for (const Bucket& bucket : stripe_window.buckets) {
+                if (bucket.interval >= oldest_interval && bucket.interval <= current_interval) {
+                    statistics.requests += bucket.requests;
+                    statistics.no_result_requests += bucket.no_result_requests;
+                }
             }
-            requests_.pop_front();
+            for (const LatencySlice& slice : stripe_window.slices) {
+                if (slice.interval >= oldest_slice && slice.interval <= current_slice) {
+                    latencies.Merge(slice.latencies);
+                }
+            }
+        }
+        const double covered_seconds = std::chrono::duration<double>(covered).count();
+        if (covered_seconds > 0) {
+            statistics.requests_per_second = statistics.requests / covered_seconds;
         }
-        requests_.push_back({current_time_, results_num});
-        if (0 == results_num) {
-            ++no_results_requests_;
+        if (statistics.requests > 0) {
+            statistics.no_result_rate = static_cast<double>(statistics.no_result_requests) / statistics.requests;
         }
-    }
\ No newline at end of file
+        statistics.p50_ns = latencies.GetPercentile(0.5);
+        statistics.p99_ns = latencies.GetPercentile(0.99);
+        statistics.p999_ns = latencies.GetPercentile(0.999);
+        return statistics;
+    }
+
+    void RequestQueue::AddRequest(size_t results_num, Clock::duration latency) {
+        const auto elapsed = now_() - start_time_;
+        const uint64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+        Stripe& stripe = stripes_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % STRIPE_COUNT];
+
+        std::lock_guard guard(stripe.mutex);
+        for (SlidingWindow& window : stripe.windows) {
+            const int64_t interval = elapsed / window.bucket_duration;
+            Bucket& bucket = window.buckets[interval % window.buckets.size()];
+            if (bucket.interval != interval) {
+                bucket.interval = interval;
+                bucket.requests = 0;
+                bucket.no_result_requests = 0;
+            }
+            ++bucket.requests;
+            if (results_num == 0) {
+                ++bucket.no_result_requests;
+            }
+
+            const int64_t slice_interval = elapsed / window.slice_duration;
+            LatencySlice& slice = window.slices[slice_interval % window.slices.size()];
+            if (slice.interval != slice_interval) {
+                slice.interval = slice_interval;
+                slice.latencies.Clear();
+            }
+            slice.latencies.Record(latency_ns);
+        }
+    }
@@ -1,37 +1,119 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string_view>
 #include <vector>
-#include <deque>
 
+#include "latency_histogram.h"
 #include "search_server.h"
 
+enum class StatisticsWindow {
+    MINUTE,
+    HOUR,
+    DAY,
+};
+
+// Статистика запросов за скользящее окно
+struct RequestStatistics {
+    uint64_t requests = 0;
+    uint64_t no_result_requests = 0;
+    double requests_per_second = 0.0;
+    double no_result_rate = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+};
+
+// Выполняет поисковые запросы и ведёт их статистику по реальному времени.
+// Окна минуты, часа и суток делятся на корзины, память не зависит от числа запросов.
+// Корзины хранят только счётчики, а время ответа пишется в гистограммы по четвертям окна;
+// перцентили считаются по последним пяти четвертям, то есть за окно и ещё не больше четверти его длины.
+// Гистограмма занимает около 2.4 КБ, на всю очередь их 8 полос * 3 окна * 5 четвертей, всего около 290 КБ.
+// AddFindRequest можно вызывать из многих потоков: замеры пишутся в одну из нескольких
+// полос по потоку, и потоки почти не делят мьютексы; чтение статистики сливает полосы
 class RequestQueue {
 public:
-    
+    using Clock = std::chrono::steady_clock;
+    // Источник времени, по которому запросы раскладываются по окнам
+    using TimeSource = std::function<Clock::time_point()>;
+
     explicit RequestQueue(const SearchServer& search_server);
+
+    // Окна отсчитываются по now, например по подменённым часам в тестах; время ответа
+    // по-прежнему измеряется по Clock
+    RequestQueue(const SearchServer& search_server, TimeSource now);
     
     template <typename DocumentPredicate>
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
-    std::vector<Document> AddFindRequest(const std::string& raw_query);
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
+    // Статус передаётся серверу как есть, а не предикатом: так работают фильтр по столбцу статусов и кеш запросов
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentStatus status);
+    std::vector<Document> AddFindRequest(std::string_view raw_query);
+
+    // Запросы без результатов за последние сутки
     int GetNoResultRequests() const;
+
+    RequestStatistics GetStatistics(StatisticsWindow window) const;
+
 private:
-    struct QueryResult {
-        uint64_t timestamp;
-        int results;
+    struct Bucket {
+        // номер интервала времени, к которому относится корзина
+        int64_t interval = -1;
+        uint64_t requests = 0;
+        uint64_t no_result_requests = 0;
     };
-    std::deque<QueryResult> requests_;
+
+    struct LatencySlice {
+        // номер части окна, к которой относится гистограмма
+        int64_t interval = -1;
+        LatencyHistogram latencies;
+    };
+
+    static const size_t STRIPE_COUNT = 8;
+    static const size_t WINDOW_COUNT = 3;
+    // окно делится на столько частей по времени ответа, и хранится на одну часть больше
+    static const size_t LATENCY_SLICE_COUNT = 4;
+
+    // Кольцо корзин по bucket_duration и кольцо гистограмм по slice_duration;
+    // корзина или гистограмма старого интервала обнуляется при первой записи
+    struct SlidingWindow {
+        Clock::duration bucket_duration;
+        std::vector<Bucket> buckets;
+        Clock::duration slice_duration;
+        std::array<LatencySlice, LATENCY_SLICE_COUNT + 1> slices;
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::array<SlidingWindow, WINDOW_COUNT> windows;
+    };
+
     const SearchServer& search_server_;
-    int no_results_requests_;
-    uint64_t current_time_;
-    const static int min_in_day_ = 1440;
- 
-    void AddRequest(int results_num);
+    const TimeSource now_;
+    const Clock::time_point start_time_;
+    std::array<Stripe, STRIPE_COUNT> stripes_;
+
+    // Выполняет поиск search() и записывает его время и число результатов
+    template <typename Search>
+    std::vector<Document> RecordRequest(Search search);
+
+    void AddRequest(size_t results_num, Clock::duration latency);
 };
 
 template <typename DocumentPredicate>
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    std::vector<Document> result = search_server_.FindTopDocuments(raw_query, document_predicate);
-    AddRequest(result.size());
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
+    return RecordRequest([&] {
+        return search_server_.FindTopDocuments(raw_query, document_predicate);
+    });
+}
+
+template <typename Search>
+std::vector<Document> RequestQueue::RecordRequest(Search search) {
+    const auto start = Clock::now();
+    std::vector<Document> result = search();
+    AddRequest(result.size(), Clock::now() - start);
     return result;
-}
\ No newline at end of file
+}
@@ -0,0 +1,65 @@
+#include "score_accumulator.h"
+
+    ScoreAccumulator::Lease::Lease(ScoreAccumulator* accumulator, std::unique_ptr<ScoreAccumulator> owned)
+        : accumulator_(accumulator)
+        , owned_(std::move(owned))
+    {
+    }
+
+    ScoreAccumulator::Lease::~Lease() {
+        accumulator_->Clear();
+        accumulator_->ShrinkIfOversized();
+        accumulator_->leased_ = false;
+    }
+
+    ScoreAccumulator* ScoreAccumulator::Lease::operator->() const {
+        return accumulator_;
+    }
+
+    ScoreAccumulator::Lease ScoreAccumulator::Acquire(size_t slot_count) {
+        thread_local ScoreAccumulator thread_accumulator;
+        std::unique_ptr<ScoreAccumulator> owned;
+        ScoreAccumulator* accumulator = &thread_accumulator;
+        if (thread_accumulator.leased_) {
+            owned = std::make_unique<ScoreAccumulator>();
+            accumulator = owned.get();
+        }
+        accumulator->leased_ = true;
+        accumulator->Reserve(slot_count);
+        return Lease(accumulator, std::move(owned));
+    }
+
+    size_t ScoreAccumulator::GetSlotCapacity() const {
+        return scores_.size();
+    }
+
+    void ScoreAccumulator::Reserve(size_t slot_count) {
+        leased_slots_ = slot_count;
+        if (scores_.size() < slot_count) {
+            scores_.resize(slot_count, 0.0);
+            states_.resize(slot_count, UNTOUCHED);
+        }
+    }
+
+    void ScoreAccumulator::Clear() {
+        for (const int slot : touched_) {
+            scores_[slot] = 0.0;
+            states_[slot] = UNTOUCHED;
+        }
+        touched_.clear();
+    }
+
+    void ScoreAccumulator::ShrinkIfOversized() {
+        if (scores_.size() <= MIN_SHRINK_SLOTS || scores_.size() <= leased_slots_ * SHRINK_FACTOR) {
+            small_leases_ = 0;
+            return;
+        }
+        if (++small_leases_ < SHRINK_AFTER_LEASES) {
+            return;
+        }
+        // после Clear все слоты пусты, так что новые массивы равны старым обрезанным
+        std::vector<double>(leased_slots_, 0.0).swap(scores_);
+        std::vector<uint8_t>(leased_slots_, UNTOUCHED).swap(states_);
+        std::vector<int>().swap(touched_);
+        small_leases_ = 0;
+    }
@@ -1,123 +1,1069 @@
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
+#include "index_snapshot.h"
+#include "read_input_functions.h"
 #include "search_server.h"
 
+struct SearchServer::SnapshotPostings {
+    SnapshotBlock document_ids;
+    SnapshotBlock term_freqs;
+    SnapshotBlock range_maxima;
+};
+
+struct SearchServer::SnapshotIndex {
+    // Частоты слов документа: номера слов в words по возрастанию и частоты
+    struct DocumentWords {
+        SnapshotBlock words;
+        SnapshotBlock term_freqs;
+    };
+
+    MappedFile file;
+    // слова словаря снимка по возрастанию
+    std::vector<std::string_view> words;
+    std::vector<SnapshotPostings> postings;
+    // по слотам снимка
+    std::vector<DocumentWords> documents;
+    std::vector<bool> occupied_slots;
+    // частоты слов документов по слотам, разобранные из documents при первом обращении.
+    // Документ снимка не меняется, поэтому кеш общий для всех копий сервера
+    std::mutex word_freqs_mutex;
+    std::map<int, std::map<std::string_view, double>> word_freqs;
+
+    explicit SnapshotIndex(const std::string& path)
+        : file(path)
+    {
+    }
+};
+
     SearchServer::SearchServer(const std::string& stop_words_text)
         : SearchServer(
             SplitIntoWords(stop_words_text))
     {
     }
 
-    void SearchServer::AddDocument(int document_id, const std::string& document, DocumentStatus status,
+    SearchServer::SearchServer(std::string_view stop_words_text)
+        : SearchServer(
+            SplitIntoWords(stop_words_text))
+    {
+    }
+
+    SearchServer::SearchServer(const SearchServer& other)
+        : stop_words_(other.stop_words_)
+        , snapshot_(other.snapshot_)
+        , own_words_(other.own_words_)
+        , document_slots_(other.document_slots_)
+        , document_ids_(other.document_ids_)
+        , document_ratings_(other.document_ratings_)
+        , document_statuses_(other.document_statuses_)
+        , status_document_counts_(other.status_document_counts_)
+        , free_slots_(other.free_slots_)
+        , docs_ids_(other.docs_ids_)
+        , snapshot_slots_(other.snapshot_slots_)
+        , duplicate_mode_(other.duplicate_mode_)
+        , fingerprint_to_documents_(other.fingerprint_to_documents_)
+        , epoch_(other.epoch_)
+    {
+        if (other.query_cache_) {
+            EnableQueryCache(other.query_cache_->GetMemoryBudget());
+        }
+        // слова снимка общие с other, собственные - из своей копии own_words_
+        for (const auto& [word, word_index] : other.word_to_document_freqs_) {
+            const auto own_word = own_words_.find(word);
+            word_to_document_freqs_.emplace_hint(word_to_document_freqs_.end(),
+                own_word == own_words_.end() ? word : std::string_view(*own_word), word_index);
+        }
+        for (const auto& [document_id, word_freqs] : other.word_freqs_ids_) {
+            auto& own_word_freqs = word_freqs_ids_[document_id];
+            for (const auto& [word, freq] : word_freqs) {
+                own_word_freqs.emplace_hint(own_word_freqs.end(), word_to_document_freqs_.find(word)->first, freq);
+            }
+        }
+        positional_index_ = other.positional_index_;
+        document_positions_ = other.document_positions_;
+        for (DocumentPositions& positions : document_positions_) {
+            for (auto& word_positions : positions.words) {
+                word_positions.word = word_to_document_freqs_.find(word_positions.word)->first;
+            }
+        }
+    }
+
+    void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
                      const std::vector<int>& ratings) {
-        if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+        STATS_SCOPED_TIMER("AddDocument"s);
+        if ((document_id < 0) || (document_slots_.count(document_id) > 0)) {
             throw std::invalid_argument("Invalid document_id"s);
         }
-        const auto words = SplitIntoWordsNoStop(document);
+        auto words = SplitIntoValidWords(document);
+        DocumentPositions positions;
+        if (positional_index_) {
+            positions = IndexWordPositions(words);
+        }
+        RemoveStopWords(words);
+
+        uint64_t fingerprint = 0;
+        if (duplicate_mode_ == DuplicateMode::REJECT) {
+            std::vector<std::string_view> distinct_words = words;
+            std::sort(distinct_words.begin(), distinct_words.end());
+            distinct_words.erase(std::unique(distinct_words.begin(), distinct_words.end()), distinct_words.end());
+            fingerprint = ComputeWordSetFingerprint(distinct_words);
+            if (FindDocumentWithWords(fingerprint, distinct_words)) {
+                throw std::invalid_argument("Document "s + std::to_string(document_id) + " is a duplicate"s);
+            }
+        }
 
+        VerifyPostings(words);
+
+        const int slot = AllocateSlot(document_id, ComputeAverageRating(ratings), status);
         const double inv_word_count = 1.0 / words.size();
-        for (const std::string& word : words) {
-            word_to_document_freqs_[word][document_id] += inv_word_count;
-            word_freqs_ids_[document_id][word] += inv_word_count;
+        for (const std::string_view word : words) {
+            const auto it = FindOrAddWord(word);
+            it->second.postings.Add(slot, inv_word_count);
+            word_freqs_ids_[document_id][it->first] += inv_word_count;
+        }
+        if (positional_index_) {
+            StoreDocumentPositions(slot, std::move(positions));
         }
-        documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
         docs_ids_.insert(document_id);
+        if (duplicate_mode_ == DuplicateMode::REJECT) {
+            fingerprint_to_documents_[fingerprint].push_back(document_id);
+        }
+        ++epoch_;
+    }
+
+    void SearchServer::AddDocuments(std::vector<DocumentRecord> documents, const BulkLoadOptions& options) {
+        auto it = documents.begin();
+        AddDocumentsPipelined([&](DocumentRecord& record) {
+            if (it == documents.end()) {
+                return false;
+            }
+            record = std::move(*it++);
+            return true;
+        }, options);
     }
 
-    std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentStatus status) const {
-        return FindTopDocuments(
-            raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-                return document_status == status;
+    void SearchServer::AddDocuments(std::istream& input, const BulkLoadOptions& options) {
+        AddDocumentsPipelined([&input](DocumentRecord& record) {
+            return ReadDocumentRecord(input, record);
+        }, options);
+    }
+
+    SearchServer::IndexedBatch SearchServer::IndexBatch(std::vector<DocumentRecord> records) const {
+        IndexedBatch batch;
+        batch.records = std::move(records);
+        for (size_t i = 0; i < batch.records.size(); ++i) {
+            std::vector<std::string_view> words;
+            try {
+                words = SplitIntoValidWords(batch.records[i].text);
+            } catch (...) {
+                batch.error = std::current_exception();
+                batch.records.resize(i);
+                break;
+            }
+            if (positional_index_) {
+                batch.positions.push_back(IndexWordPositions(words));
+            }
+            RemoveStopWords(words);
+            // частота копится сложением так же, как в AddDocument, чтобы индексы совпадали до бита
+            const double inv_word_count = 1.0 / words.size();
+            std::sort(words.begin(), words.end());
+            for (size_t begin = 0, end = 0; begin < words.size(); begin = end) {
+                double term_freq = 0;
+                for (end = begin; end < words.size() && words[end] == words[begin]; ++end) {
+                    term_freq += inv_word_count;
+                }
+                batch.postings.push_back({words[begin], i, term_freq});
+            }
+            if (duplicate_mode_ == DuplicateMode::REJECT) {
+                words.erase(std::unique(words.begin(), words.end()), words.end());
+                batch.fingerprints.push_back(ComputeWordSetFingerprint(words));
+                batch.document_words.push_back(std::move(words));
+            }
+        }
+        std::stable_sort(batch.postings.begin(), batch.postings.end(),
+            [](const IndexedBatch::WordPosting& lhs, const IndexedBatch::WordPosting& rhs) {
+                return lhs.word < rhs.word;
             });
+        return batch;
+    }
+
+    void SearchServer::MergeBatch(IndexedBatch batch) {
+        if (snapshot_) {
+            std::vector<std::string_view> words;
+            for (const auto& word_posting : batch.postings) {
+                if (words.empty() || words.back() != word_posting.word) {
+                    words.push_back(word_posting.word);
+                }
+            }
+            VerifyPostings(words);
+        }
+        std::exception_ptr error = batch.error;
+        size_t document_count = batch.records.size();
+        // документы пачки ещё не попали в прямой индекс, поэтому дубликаты внутри пачки ищутся отдельно
+        std::unordered_map<uint64_t, std::vector<size_t>> batch_fingerprints;
+        std::vector<int> slots;
+        slots.reserve(document_count);
+        for (size_t i = 0; i < document_count; ++i) {
+            const DocumentRecord& record = batch.records[i];
+            if ((record.id < 0) || (document_slots_.count(record.id) > 0)) {
+                error = std::make_exception_ptr(std::invalid_argument("Invalid document_id"s));
+                document_count = i;
+                break;
+            }
+            if (duplicate_mode_ == DuplicateMode::REJECT) {
+                const auto& words = batch.document_words[i];
+                auto& same_fingerprint = batch_fingerprints[batch.fingerprints[i]];
+                if (FindDocumentWithWords(batch.fingerprints[i], words)
+                    || std::any_of(same_fingerprint.begin(), same_fingerprint.end(),
+                           [&](size_t index) { return batch.document_words[index] == words; })) {
+                    error = std::make_exception_ptr(std::invalid_argument(
+                        "Document "s + std::to_string(record.id) + " is a duplicate"s));
+                    document_count = i;
+                    break;
+                }
+                same_fingerprint.push_back(i);
+            }
+            slots.push_back(AllocateSlot(record.id, ComputeAverageRating(record.ratings), record.status));
+            docs_ids_.insert(record.id);
+        }
+        if (duplicate_mode_ == DuplicateMode::REJECT) {
+            for (size_t i = 0; i < document_count; ++i) {
+                fingerprint_to_documents_[batch.fingerprints[i]].push_back(batch.records[i].id);
+            }
+        }
+        ++epoch_;
+
+        std::vector<std::map<std::string_view, double>*> document_word_freqs(document_count, nullptr);
+        auto it = word_to_document_freqs_.end();
+        for (const auto& [word, document_index, term_freq] : batch.postings) {
+            if (document_index >= document_count) {
+                continue;
+            }
+            if (it == word_to_document_freqs_.end() || it->first != word) {
+                it = FindOrAddWord(word);
+            }
+            it->second.postings.Add(slots[document_index], term_freq);
+            auto*& word_freqs = document_word_freqs[document_index];
+            if (word_freqs == nullptr) {
+                word_freqs = &word_freqs_ids_[batch.records[document_index].id];
+            }
+            // слова пачки идут по возрастанию, поэтому вставка всегда в конец
+            word_freqs->emplace_hint(word_freqs->end(), it->first, term_freq);
+        }
+        if (positional_index_) {
+            for (size_t i = 0; i < document_count; ++i) {
+                StoreDocumentPositions(slots[i], std::move(batch.positions[i]));
+            }
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                      SearchOptions options) const {
+        return FindTopDocuments(std::execution::seq, raw_query, status, options);
+    }
+
+    std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, SearchOptions options) const {
+        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL, options);
+    }
+
+    void SearchServer::SetDuplicateMode(DuplicateMode mode) {
+        // частоты слов документов снимка читаются при первом обращении и могут оказаться испорчены,
+        // поэтому отпечатки собираются до смены режима
+        std::unordered_map<uint64_t, std::vector<int>> fingerprint_to_documents;
+        if (mode == DuplicateMode::REJECT) {
+            for (const int document_id : docs_ids_) {
+                fingerprint_to_documents[GetDocumentFingerprint(document_id)].push_back(document_id);
+            }
+        }
+        duplicate_mode_ = mode;
+        fingerprint_to_documents_ = std::move(fingerprint_to_documents);
     }
 
-    std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query) const {
-        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+    DuplicateMode SearchServer::GetDuplicateMode() const {
+        return duplicate_mode_;
+    }
+
+    void SearchServer::EnablePositionalIndex() {
+        if (!positional_index_ && !document_slots_.empty()) {
+            throw std::logic_error("Positional index must be enabled before adding documents"s);
+        }
+        positional_index_ = true;
+    }
+
+    bool SearchServer::HasPositionalIndex() const {
+        return positional_index_;
+    }
+
+    uint64_t SearchServer::GetDocumentFingerprint(int document_id) const {
+        uint64_t fingerprint = 0;
+        for (const auto& [word, _] : GetWordFrequencies(document_id)) {
+            fingerprint += ComputeWordFingerprint(word);
+        }
+        return fingerprint;
+    }
+
+    void SearchServer::EnableQueryCache(size_t memory_budget) {
+        query_cache_ = std::make_unique<QueryResultCache>(memory_budget);
+    }
+
+    void SearchServer::DisableQueryCache() {
+        query_cache_.reset();
+    }
+
+    QueryCacheStats SearchServer::GetQueryCacheStats() const {
+        return query_cache_ ? query_cache_->GetStats() : QueryCacheStats();
+    }
+
+    std::string SearchServer::GetStats(StatsFormat format) const {
+        std::ostringstream out;
+        if (format == StatsFormat::TEXT) {
+            out << "documents: "s << document_ids_.size() << "\nwords: "s << word_to_document_freqs_.size()
+                << "\npostings_bytes: "s << GetPostingsMemoryUsage() << '\n';
+            PrintStatsSnapshot(out, StatsRegistry::Instance().Collect(), format);
+        } else {
+            out << "{\"documents\": "s << document_ids_.size() << ", \"words\": "s << word_to_document_freqs_.size()
+                << ", \"postings_bytes\": "s << GetPostingsMemoryUsage() << ", "s;
+            PrintStatsSnapshot(out, StatsRegistry::Instance().Collect(), format);
+            out << '}';
+        }
+        return out.str();
+    }
+
+    void SearchServer::CompressPostings() {
+        std::vector<WordIndex*> word_indexes;
+        word_indexes.reserve(word_to_document_freqs_.size());
+        for (auto& [_, word_index] : word_to_document_freqs_) {
+            word_indexes.push_back(&word_index);
+        }
+        // исключение из параллельного алгоритма завершило бы программу, поэтому порча снимка
+        // запоминается и сообщается после; сжатие части списков выдачу не меняет
+        std::atomic<bool> is_corrupted = false;
+        std::for_each(std::execution::par, word_indexes.begin(), word_indexes.end(),
+            [this, &is_corrupted](WordIndex* word_index) {
+                try {
+                    VerifyPostings(*word_index);
+                } catch (const std::runtime_error&) {
+                    is_corrupted = true;
+                    return;
+                }
+                word_index->postings.Compress();
+            });
+        if (is_corrupted) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+    }
+
+    size_t SearchServer::GetPostingsMemoryUsage() const {
+        size_t memory_usage = 0;
+        for (const auto& [_, word_index] : word_to_document_freqs_) {
+            memory_usage += word_index.postings.GetMemoryUsage();
+        }
+        return memory_usage;
+    }
+
+    size_t SearchServer::GetPositionsMemoryUsage() const {
+        size_t memory_usage = document_positions_.capacity() * sizeof(DocumentPositions);
+        for (const DocumentPositions& positions : document_positions_) {
+            memory_usage += positions.words.capacity() * sizeof(DocumentPositions::WordPositions)
+                + positions.positions.capacity() * sizeof(uint32_t);
+        }
+        return memory_usage;
     }
 
     int SearchServer::GetDocumentCount() const {
-        return documents_.size();
+        return document_slots_.size();
     }
 
-    const std::map<std::string, double>& SearchServer::GetWordFrequencies(int document_id) const {
+    const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
         if (word_freqs_ids_.count(document_id)) {
             return word_freqs_ids_.at(document_id);
         }
+        const auto document_slot = document_slots_.find(document_id);
+        if (document_slot != document_slots_.end() && static_cast<size_t>(document_slot->second) < snapshot_slots_.size()
+            && snapshot_slots_[document_slot->second]) {
+            return GetSnapshotWordFrequencies(document_slot->second);
+        }
         else {
-            static const std::map<std::string, double> res;
+            static const std::map<std::string_view, double> res;
         return res;
         }
     }
 
-    std::set<int>::const_iterator SearchServer::begin() {
+    const std::map<std::string_view, double>& SearchServer::GetSnapshotWordFrequencies(int slot) const {
+        std::lock_guard lock(snapshot_->word_freqs_mutex);
+        auto& word_freqs = snapshot_->word_freqs;
+        const auto it = word_freqs.find(slot);
+        if (it != word_freqs.end()) {
+            return it->second;
+        }
+        const auto& document = snapshot_->documents[slot];
+        if (!document.words.IsIntact() || !document.term_freqs.IsIntact()) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+        const uint32_t* word_indexes = document.words.GetValues<uint32_t>();
+        const double* term_freqs = document.term_freqs.GetValues<double>();
+        const size_t word_count = document.words.bytes.size() / sizeof(uint32_t);
+        std::map<std::string_view, double> document_word_freqs;
+        for (size_t i = 0; i < word_count; ++i) {
+            // SaveSnapshot пишет слова документа строго по возрастанию номеров
+            if (word_indexes[i] >= snapshot_->words.size() || (i > 0 && word_indexes[i] <= word_indexes[i - 1])) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            document_word_freqs.emplace_hint(document_word_freqs.end(), snapshot_->words[word_indexes[i]], term_freqs[i]);
+        }
+        return word_freqs.emplace(slot, std::move(document_word_freqs)).first->second;
+    }
+
+    std::set<int>::const_iterator SearchServer::begin() const {
         return docs_ids_.begin();
     }
     
-    std::set<int>::const_iterator SearchServer::end() {
+    std::set<int>::const_iterator SearchServer::end() const {
         return docs_ids_.end();
     }
 
-    std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string& raw_query,
-                                                        int document_id) const {
+    SearchServer::MatchedWords SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+        return MatchDocument(std::execution::seq, raw_query, document_id);
+    }
+
+    SearchServer::MatchedWords SearchServer::MatchDocument(const std::execution::sequenced_policy&,
+                                                           std::string_view raw_query, int document_id) const {
+        STATS_SCOPED_TIMER("MatchDocument"s);
+        const DocumentStatus status = document_statuses_[GetDocumentSlot(document_id)];
         const auto query = ParseQuery(raw_query);
+        const auto& word_freqs = GetWordFrequencies(document_id);
 
-        std::vector<std::string> matched_words;
-        for (const std::string& word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
+        for (const std::string_view word : query.minus_words) {
+            if (word_freqs.count(word)) {
+                return {std::vector<std::string_view>(), status};
+            }
+        }
+        if (!SatisfiesRequirements(query, document_id)) {
+            return {std::vector<std::string_view>(), status};
+        }
+        std::vector<std::string_view> matched_words;
+        for (const std::string_view word : query.plus_words) {
+            const auto it = word_freqs.find(word);
+            if (it != word_freqs.end()) {
+                matched_words.push_back(it->first);
+            }
+        }
+        return {matched_words, status};
+    }
+
+    SearchServer::MatchedWords SearchServer::MatchDocument(const std::execution::parallel_policy&,
+                                                           std::string_view raw_query, int document_id) const {
+        STATS_SCOPED_TIMER("MatchDocument"s);
+        const DocumentStatus status = document_statuses_[GetDocumentSlot(document_id)];
+        const auto query = ParseQuery(raw_query, false);
+        const auto& word_freqs = GetWordFrequencies(document_id);
+
+        if (std::any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
+                [&word_freqs](std::string_view word) {
+                    return word_freqs.count(word) > 0;
+                }) || !SatisfiesRequirements(query, document_id)) {
+            return {std::vector<std::string_view>(), status};
+        }
+
+        // найденное слово заменяется строкой из словаря, ненайденное - пустой строкой
+        std::vector<std::string_view> matched_words(query.plus_words.size());
+        std::transform(std::execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+            [&word_freqs](std::string_view word) {
+                const auto it = word_freqs.find(word);
+                return it == word_freqs.end() ? std::string_view() : it->first;
+            });
+        matched_words.erase(std::remove(matched_words.begin(), matched_words.end(), std::string_view()), matched_words.end());
+        std::sort(std::execution::par, matched_words.begin(), matched_words.end());
+        matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+        return {matched_words, status};
+    }
+
+    void SearchServer::SaveSnapshot(const std::string& path) const {
+        SnapshotWriter writer(path);
+
+        writer.Write<uint64_t>(stop_words_.size());
+        for (const std::string& word : stop_words_) {
+            writer.WriteString(word);
+        }
+
+        // документы пишутся по слотам вместе со свободными, так что списки вхождений пишутся как есть
+        std::vector<uint8_t> statuses(document_statuses_.size());
+        std::transform(document_statuses_.begin(), document_statuses_.end(), statuses.begin(),
+            [](DocumentStatus status) {
+                return static_cast<uint8_t>(status);
+            });
+        writer.WriteArray(document_ids_);
+        writer.WriteArray(document_ratings_);
+        writer.WriteArray(statuses);
+        writer.WriteArray(free_slots_);
+
+        writer.Write<uint64_t>(word_to_document_freqs_.size());
+        for (const auto& [word, word_index] : word_to_document_freqs_) {
+            writer.WriteString(word);
+            const PostingList& postings = GetPostings(word_index);
+            const PostingList::Data data = postings.GetData();
+            writer.Write<uint64_t>(postings.size());
+            writer.Write<double>(data.max_term_freq);
+            writer.Write<int64_t>(data.range_width);
+            writer.Write<uint64_t>(data.range_count);
+            if (postings.IsCompressed()) {
+                const std::vector<int> document_ids = postings.GetDocumentIds();
+                const std::vector<double> term_freqs = postings.GetTermFreqs();
+                writer.WriteBlock(document_ids.data(), document_ids.size());
+                writer.WriteBlock(term_freqs.data(), term_freqs.size());
+            } else {
+                writer.WriteBlock(data.document_ids, data.size);
+                writer.WriteBlock(data.term_freqs, data.size);
+            }
+            writer.WriteBlock(data.range_maxima, data.range_count);
+        }
+
+        // частоты слов по документам: номера слов в словаре по возрастанию и частоты, по слотам
+        std::map<std::string_view, uint32_t> word_indexes;
+        for (const auto& [word, _] : word_to_document_freqs_) {
+            word_indexes.emplace_hint(word_indexes.end(), word, word_indexes.size());
+        }
+        for (const int document_id : document_ids_) {
+            std::vector<uint32_t> document_words;
+            std::vector<double> term_freqs;
+            if (document_id != NO_DOCUMENT_ID) {
+                for (const auto& [word, term_freq] : GetWordFrequencies(document_id)) {
+                    document_words.push_back(word_indexes.at(word));
+                    term_freqs.push_back(term_freq);
+                }
             }
-            if (word_to_document_freqs_.at(word).count(document_id)) {
-                matched_words.push_back(word);
+            writer.Write<uint64_t>(document_words.size());
+            writer.WriteBlock(document_words.data(), document_words.size());
+            writer.WriteBlock(term_freqs.data(), term_freqs.size());
+        }
+
+        // позиции: у каждого слота номера слов в словаре по порядку текста, NO_WORD на месте стоп-слов
+        writer.Write<uint8_t>(positional_index_);
+        if (positional_index_) {
+            const uint32_t NO_WORD = UINT32_MAX;
+            for (size_t slot = 0; slot < document_ids_.size(); ++slot) {
+                std::vector<uint32_t> text_words;
+                if (document_ids_[slot] != NO_DOCUMENT_ID) {
+                    const DocumentPositions& positions = document_positions_[slot];
+                    uint32_t begin = 0;
+                    for (const auto& [word, end] : positions.words) {
+                        const uint32_t word_index = word_indexes.at(word);
+                        for (uint32_t i = begin; i < end; ++i) {
+                            const uint32_t position = positions.positions[i];
+                            if (text_words.size() <= position) {
+                                text_words.resize(position + 1, NO_WORD);
+                            }
+                            text_words[position] = word_index;
+                        }
+                        begin = end;
+                    }
+                }
+                writer.WriteArray(text_words);
             }
         }
-        for (const std::string& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+
+        writer.Commit();
+    }
+
+    SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+        const auto snapshot = std::make_shared<SnapshotIndex>(path);
+        SnapshotReader reader(snapshot->file.GetData());
+
+        std::vector<std::string_view> stop_words(reader.Read<uint64_t>());
+        for (std::string_view& word : stop_words) {
+            word = reader.ReadString();
+        }
+        SearchServer search_server(stop_words);
+
+        auto document_ids = reader.ReadArray<int>();
+        auto ratings = reader.ReadArray<int>();
+        const auto statuses = reader.ReadArray<uint8_t>();
+        auto free_slots = reader.ReadArray<int>();
+        if (ratings.size() != document_ids.size() || statuses.size() != document_ids.size()) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+        const size_t slot_count = document_ids.size();
+        snapshot->occupied_slots.resize(slot_count);
+        for (size_t slot = 0; slot < slot_count; ++slot) {
+            if (document_ids[slot] == NO_DOCUMENT_ID) {
                 continue;
             }
-            if (word_to_document_freqs_.at(word).count(document_id)) {
-                matched_words.clear();
-                break;
+            if (document_ids[slot] < 0 || statuses[slot] >= DOCUMENT_STATUS_COUNT
+                || !search_server.document_slots_.emplace(document_ids[slot], slot).second) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            snapshot->occupied_slots[slot] = true;
+            ++search_server.status_document_counts_[statuses[slot]];
+            // документы обычно идут по возрастанию id, тогда вставка с подсказкой в конец стоит O(1)
+            search_server.docs_ids_.emplace_hint(search_server.docs_ids_.end(), document_ids[slot]);
+        }
+        // свободные слоты - ровно все незанятые, каждый по разу
+        std::vector<bool> is_free_slot(slot_count);
+        for (const int slot : free_slots) {
+            if (slot < 0 || static_cast<size_t>(slot) >= slot_count || snapshot->occupied_slots[slot]
+                || is_free_slot[slot]) {
+                throw std::runtime_error("Snapshot is corrupted"s);
             }
+            is_free_slot[slot] = true;
+        }
+        if (free_slots.size() + search_server.document_slots_.size() != slot_count) {
+            throw std::runtime_error("Snapshot is corrupted"s);
         }
-        return {matched_words, documents_.at(document_id).status};
+        search_server.document_ids_ = std::move(document_ids);
+        search_server.document_ratings_ = std::move(ratings);
+        search_server.document_statuses_.reserve(slot_count);
+        for (const uint8_t status : statuses) {
+            search_server.document_statuses_.push_back(static_cast<DocumentStatus>(status));
+        }
+        search_server.free_slots_ = std::move(free_slots);
+
+        // вхождения только описываются: их блоки проверит VerifyPostings при первом обращении к слову
+        const uint64_t word_count = reader.Read<uint64_t>();
+        std::vector<PostingList::Data> postings_data;
+        for (uint64_t word_index = 0; word_index < word_count; ++word_index) {
+            const std::string_view word = reader.ReadString();
+            // SaveSnapshot пишет словарь строго по возрастанию, повтор или нарушение порядка - порча файла
+            if (word_index > 0 && word <= snapshot->words.back()) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            PostingList::Data data;
+            data.size = reader.Read<uint64_t>();
+            data.max_term_freq = reader.Read<double>();
+            data.range_width = reader.Read<int64_t>();
+            data.range_count = reader.Read<uint64_t>();
+            const SnapshotBlock document_ids_block = reader.ReadBlock<int>(data.size);
+            const SnapshotBlock term_freqs_block = reader.ReadBlock<double>(data.size);
+            const SnapshotBlock range_maxima_block = reader.ReadBlock<PostingList::RangeMax>(data.range_count);
+            if (data.size == 0 || data.range_width < 0 || (data.range_count > 0 && data.range_width == 0)) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            data.document_ids = document_ids_block.GetValues<int>();
+            data.term_freqs = term_freqs_block.GetValues<double>();
+            data.range_maxima = range_maxima_block.GetValues<PostingList::RangeMax>();
+            snapshot->words.push_back(word);
+            snapshot->postings.push_back({document_ids_block, term_freqs_block, range_maxima_block});
+            postings_data.push_back(data);
+        }
+        for (size_t word_index = 0; word_index < snapshot->words.size(); ++word_index) {
+            auto& word_index_entry = search_server.word_to_document_freqs_.emplace_hint(
+                search_server.word_to_document_freqs_.end(), snapshot->words[word_index],
+                WordIndex(PostingList::FromData(postings_data[word_index])))->second;
+            word_index_entry.unverified_postings.store(&snapshot->postings[word_index], std::memory_order_relaxed);
+        }
+
+        snapshot->documents.reserve(slot_count);
+        for (size_t slot = 0; slot < slot_count; ++slot) {
+            const uint64_t word_count = reader.Read<uint64_t>();
+            const SnapshotBlock words = reader.ReadBlock<uint32_t>(word_count);
+            const SnapshotBlock term_freqs = reader.ReadBlock<double>(word_count);
+            if (!snapshot->occupied_slots[slot] && word_count > 0) {
+                throw std::runtime_error("Snapshot is corrupted"s);
+            }
+            snapshot->documents.push_back({words, term_freqs});
+        }
+
+        search_server.positional_index_ = reader.Read<uint8_t>() != 0;
+        if (search_server.positional_index_) {
+            const uint32_t NO_WORD = UINT32_MAX;
+            search_server.document_positions_.resize(slot_count);
+            for (auto& positions : search_server.document_positions_) {
+                const auto text_words = reader.ReadArray<uint32_t>();
+                std::vector<std::pair<std::string_view, uint32_t>> word_positions;
+                word_positions.reserve(text_words.size());
+                for (size_t position = 0; position < text_words.size(); ++position) {
+                    if (text_words[position] == NO_WORD) {
+                        continue;
+                    }
+                    if (text_words[position] >= snapshot->words.size()) {
+                        throw std::runtime_error("Snapshot is corrupted"s);
+                    }
+                    word_positions.push_back({snapshot->words[text_words[position]], static_cast<uint32_t>(position)});
+                }
+                positions = MakeDocumentPositions(std::move(word_positions));
+            }
+        }
+        if (!reader.AtEnd()) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+        search_server.snapshot_slots_ = snapshot->occupied_slots;
+        search_server.snapshot_ = snapshot;
+        return search_server;
     }
 
     void SearchServer::RemoveDocument(int document_id) {
-        for (auto [word, _] : word_freqs_ids_.at(document_id)) {
-            word_to_document_freqs_.at(word).erase(document_id);
-            if (word_to_document_freqs_.at(word).empty()) {
-                word_to_document_freqs_.erase(word);
+        RemoveDocument(std::execution::seq, document_id);
+    }
+
+    void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int document_id) {
+        STATS_SCOPED_TIMER("RemoveDocument"s);
+        const auto document_slot = document_slots_.find(document_id);
+        if (document_slot == document_slots_.end()) {
+            return;
+        }
+        const int slot = document_slot->second;
+        const auto& word_freqs = GetWordFrequencies(document_id);
+        for (const auto& [word, _] : word_freqs) {
+            VerifyPostings(word_to_document_freqs_.find(word)->second);
+        }
+        ForgetFingerprint(document_id);
+        for (const auto& [word, _] : word_freqs) {
+            const auto it = word_to_document_freqs_.find(word);
+            it->second.postings.Remove(slot);
+            if (it->second.postings.empty()) {
+                EraseWord(it);
             }
         }
-        documents_.erase(document_id);
-        word_freqs_ids_.erase(document_id);
+        ForgetWordFrequencies(document_id, slot);
+        if (positional_index_) {
+            document_positions_[slot] = DocumentPositions();
+        }
+        ReleaseSlot(slot);
+        document_slots_.erase(document_slot);
+        docs_ids_.erase(document_id);
+        ++epoch_;
+    }
+
+    void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id) {
+        STATS_SCOPED_TIMER("RemoveDocument"s);
+        const auto document_slot = document_slots_.find(document_id);
+        if (document_slot == document_slots_.end()) {
+            return;
+        }
+        const int slot = document_slot->second;
+        const auto& word_freqs = GetWordFrequencies(document_id);
+        std::vector<Dictionary::iterator> postings(word_freqs.size());
+        std::transform(std::execution::par, word_freqs.begin(), word_freqs.end(), postings.begin(),
+            [this](const auto& word_freq) {
+                return word_to_document_freqs_.find(word_freq.first);
+            });
+        // проверка бросает исключение, поэтому идёт до параллельных удалений
+        for (const auto& it : postings) {
+            VerifyPostings(it->second);
+        }
+        ForgetFingerprint(document_id);
+        // у каждого слова свой список, поэтому удаления из разных списков не пересекаются
+        std::for_each(std::execution::par, postings.begin(), postings.end(),
+            [slot](const auto& it) {
+                it->second.postings.Remove(slot);
+            });
+        for (const auto& it : postings) {
+            if (it->second.postings.empty()) {
+                EraseWord(it);
+            }
+        }
+        ForgetWordFrequencies(document_id, slot);
+        if (positional_index_) {
+            document_positions_[slot] = DocumentPositions();
+        }
+        ReleaseSlot(slot);
+        document_slots_.erase(document_slot);
         docs_ids_.erase(document_id);
+        ++epoch_;
+    }
+
+    void SearchServer::ForgetWordFrequencies(int document_id, int slot) {
+        const auto document_words = word_freqs_ids_.find(document_id);
+        if (document_words != word_freqs_ids_.end()) {
+            word_freqs_ids_.erase(document_words);
+        } else if (static_cast<size_t>(slot) < snapshot_slots_.size()) {
+            snapshot_slots_[slot] = false;
+        }
+    }
+
+    SearchServer::Dictionary::iterator SearchServer::FindOrAddWord(std::string_view word) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it != word_to_document_freqs_.end()) {
+            return it;
+        }
+        return word_to_document_freqs_.emplace(*own_words_.emplace(word).first, WordIndex()).first;
+    }
+
+    void SearchServer::EraseWord(Dictionary::iterator it) {
+        const auto own_word = own_words_.find(it->first);
+        word_to_document_freqs_.erase(it);
+        if (own_word != own_words_.end()) {
+            own_words_.erase(own_word);
+        }
+    }
+
+    void SearchServer::VerifyPostings(const WordIndex& word_index) const {
+        const SnapshotPostings* snapshot_postings = word_index.unverified_postings.load(std::memory_order_acquire);
+        if (snapshot_postings == nullptr) {
+            return;
+        }
+        // несколько константных запросов могут проверять список одновременно, проверка от этого не меняется
+        const PostingList::Data data = word_index.postings.GetData();
+        bool is_intact = snapshot_postings->document_ids.IsIntact() && snapshot_postings->term_freqs.IsIntact()
+            && snapshot_postings->range_maxima.IsIntact();
+        // слоты строго возрастают и заняты документами снимка
+        for (size_t i = 0; i < data.size && is_intact; ++i) {
+            const int slot = data.document_ids[i];
+            is_intact = slot >= 0 && static_cast<size_t>(slot) < snapshot_->occupied_slots.size()
+                && snapshot_->occupied_slots[slot] && (i == 0 || slot > data.document_ids[i - 1]);
+        }
+        for (size_t i = 1; i < data.range_count && is_intact; ++i) {
+            is_intact = data.range_maxima[i].range > data.range_maxima[i - 1].range;
+        }
+        if (!is_intact) {
+            throw std::runtime_error("Snapshot is corrupted"s);
+        }
+        word_index.unverified_postings.store(nullptr, std::memory_order_release);
+    }
+
+    void SearchServer::VerifyPostings(const std::vector<std::string_view>& words) const {
+        if (!snapshot_) {
+            return;
+        }
+        for (const std::string_view word : words) {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it != word_to_document_freqs_.end()) {
+                VerifyPostings(it->second);
+            }
+        }
+    }
+
+    const PostingList& SearchServer::GetPostings(const WordIndex& word_index) const {
+        VerifyPostings(word_index);
+        return word_index.postings;
     }
  
 
-    bool SearchServer::IsStopWord(const std::string& word) const {
+    std::string SearchServer::MakeQueryCacheKey(const Query& query, DocumentStatus status, SearchOptions options) {
+        // слова не содержат управляющих символов, поэтому '\1' однозначно разделяет части ключа
+        std::string key;
+        for (const std::string_view word : query.plus_words) {
+            key.append(word).push_back('\1');
+        }
+        key.push_back('-');
+        for (const std::string_view word : query.minus_words) {
+            key.append(word).push_back('\1');
+        }
+        // слова фраз могут начинаться с любых символов, поэтому обязательные слова и фразы отделены '\2'
+        key.push_back('\2');
+        for (const std::string_view word : query.required_words) {
+            key.append(word).push_back('\1');
+        }
+        for (const Phrase& phrase : query.phrases) {
+            key.push_back('\2');
+            for (const auto& [word, offset] : phrase) {
+                key.append(word).push_back('\1');
+                key += std::to_string(offset);
+                key.push_back('\1');
+            }
+        }
+        key.push_back('\2');
+        key += std::to_string(static_cast<int>(status));
+        key.push_back('\1');
+        key += std::to_string(options.offset);
+        key.push_back('\1');
+        key += std::to_string(options.count);
+        // WAND и полный перебор могут по-разному упорядочить документы с почти равной релевантностью
+        key.push_back('\1');
+        key += std::to_string(static_cast<int>(options.algorithm));
+        return key;
+    }
+
+    bool SearchServer::RanksHigher(const Document& lhs, const Document& rhs) {
+        if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_EPSILON) {
+            if (lhs.rating == rhs.rating) {
+                return lhs.id < rhs.id;
+            }
+            return lhs.rating > rhs.rating;
+        } else {
+            return lhs.relevance > rhs.relevance;
+        }
+    }
+
+    size_t SearchServer::GetWindowEnd(SearchOptions options) {
+        return options.count > std::numeric_limits<size_t>::max() - options.offset
+            ? std::numeric_limits<size_t>::max()
+            : options.offset + options.count;
+    }
+
+    uint64_t SearchServer::ComputeWordSetFingerprint(const std::vector<std::string_view>& words) {
+        uint64_t fingerprint = 0;
+        for (const std::string_view word : words) {
+            fingerprint += ComputeWordFingerprint(word);
+        }
+        return fingerprint;
+    }
+
+    std::optional<int> SearchServer::FindDocumentWithWords(uint64_t fingerprint,
+                                                           const std::vector<std::string_view>& words) const {
+        const auto candidates = fingerprint_to_documents_.find(fingerprint);
+        if (candidates == fingerprint_to_documents_.end()) {
+            return std::nullopt;
+        }
+        // совпадение отпечатков проверяется сравнением наборов слов, так что коллизии не дают ложных дубликатов
+        for (const int document_id : candidates->second) {
+            const auto& word_freqs = GetWordFrequencies(document_id);
+            if (std::equal(word_freqs.begin(), word_freqs.end(), words.begin(), words.end(),
+                    [](const auto& word_freq, std::string_view word) {
+                        return word_freq.first == word;
+                    })) {
+                return document_id;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void SearchServer::ForgetFingerprint(int document_id) {
+        if (duplicate_mode_ != DuplicateMode::REJECT || document_slots_.count(document_id) == 0) {
+            return;
+        }
+        const auto candidates = fingerprint_to_documents_.find(GetDocumentFingerprint(document_id));
+        auto& document_ids = candidates->second;
+        document_ids.erase(std::find(document_ids.begin(), document_ids.end(), document_id));
+        if (document_ids.empty()) {
+            fingerprint_to_documents_.erase(candidates);
+        }
+    }
+
+    bool SearchServer::IsStopWord(std::string_view word) const {
         return stop_words_.count(word) > 0;
     }
 
-    bool SearchServer::IsValidWord(const std::string& word) {
+    bool SearchServer::IsValidWord(std::string_view word) {
         // A valid word must not contain special characters
-        return none_of(word.begin(), word.end(), [](char c) {
-            return c >= '\0' && c < ' ';
-        });
+        return !ContainsControlChars(word);
+    }
+
+    std::vector<std::string_view> SearchServer::SplitIntoValidWords(std::string_view text) {
+        auto [words, first_invalid_word] = SplitIntoCheckedWords(text);
+        if (first_invalid_word) {
+            throw std::invalid_argument("Word "s + std::string(words[*first_invalid_word]) + " is invalid"s);
+        }
+        return words;
+    }
+
+    void SearchServer::RemoveStopWords(std::vector<std::string_view>& words) const {
+        words.erase(std::remove_if(words.begin(), words.end(),
+            [this](std::string_view word) {
+                return IsStopWord(word);
+            }), words.end());
     }
 
-    std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-        std::vector<std::string> words;
-        for (const std::string& word : SplitIntoWords(text)) {
-            if (!IsValidWord(word)) {
-                throw std::invalid_argument("Word "s + word + " is invalid"s);
+    std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+        auto words = SplitIntoValidWords(text);
+        RemoveStopWords(words);
+        return words;
+    }
+
+    SearchServer::DocumentPositions SearchServer::IndexWordPositions(const std::vector<std::string_view>& words) const {
+        std::vector<std::pair<std::string_view, uint32_t>> word_positions;
+        word_positions.reserve(words.size());
+        for (size_t position = 0; position < words.size(); ++position) {
+            if (!IsStopWord(words[position])) {
+                word_positions.push_back({words[position], static_cast<uint32_t>(position)});
             }
-            if (!IsStopWord(word)) {
-                words.push_back(word);
+        }
+        return MakeDocumentPositions(std::move(word_positions));
+    }
+
+    SearchServer::DocumentPositions SearchServer::MakeDocumentPositions(
+            std::vector<std::pair<std::string_view, uint32_t>> word_positions) {
+        std::sort(word_positions.begin(), word_positions.end());
+        DocumentPositions positions;
+        positions.positions.reserve(word_positions.size());
+        for (const auto& [word, position] : word_positions) {
+            if (positions.words.empty() || positions.words.back().word != word) {
+                positions.words.push_back({word, 0});
             }
+            positions.positions.push_back(position);
+            positions.words.back().end = positions.positions.size();
         }
-        return words;
+        positions.words.shrink_to_fit();
+        return positions;
+    }
+
+    void SearchServer::StoreDocumentPositions(int slot, DocumentPositions positions) {
+        for (auto& word_positions : positions.words) {
+            word_positions.word = word_to_document_freqs_.find(word_positions.word)->first;
+        }
+        if (document_positions_.size() <= static_cast<size_t>(slot)) {
+            document_positions_.resize(slot + 1);
+        }
+        document_positions_[slot] = std::move(positions);
+    }
+
+    std::pair<const uint32_t*, const uint32_t*> SearchServer::FindWordPositions(const DocumentPositions& positions,
+                                                                                std::string_view word) {
+        const auto it = std::lower_bound(positions.words.begin(), positions.words.end(), word,
+            [](const DocumentPositions::WordPositions& word_positions, std::string_view word) {
+                return word_positions.word < word;
+            });
+        if (it == positions.words.end() || it->word != word) {
+            return {nullptr, nullptr};
+        }
+        const uint32_t begin = it == positions.words.begin() ? 0 : std::prev(it)->end;
+        return {positions.positions.data() + begin, positions.positions.data() + it->end};
+    }
+
+    bool SearchServer::ContainsPhrase(const DocumentPositions& positions, const Phrase& phrase,
+                                      std::vector<PhraseWordPositions>& word_positions) {
+        word_positions.clear();
+        for (const auto& [word, offset] : phrase) {
+            const auto [begin, end] = FindWordPositions(positions, word);
+            if (begin == end) {
+                return false;
+            }
+            word_positions.push_back({begin, end, offset});
+        }
+        // начало фразы перебирается по вхождениям самого редкого слова, остальные ищутся
+        // двоичным поиском, причём только вперёд, так как начала возрастают
+        std::sort(word_positions.begin(), word_positions.end(),
+            [](const PhraseWordPositions& lhs, const PhraseWordPositions& rhs) {
+                return lhs.end - lhs.begin < rhs.end - rhs.begin;
+            });
+        const PhraseWordPositions& rarest = word_positions.front();
+        for (const uint32_t* anchor = rarest.begin; anchor != rarest.end; ++anchor) {
+            if (*anchor < rarest.offset) {
+                continue;
+            }
+            const uint32_t phrase_begin = *anchor - rarest.offset;
+            bool is_found = true;
+            for (size_t i = 1; i < word_positions.size() && is_found; ++i) {
+                PhraseWordPositions& other = word_positions[i];
+                other.begin = std::lower_bound(other.begin, other.end, phrase_begin + other.offset);
+                if (other.begin == other.end) {
+                    return false;
+                }
+                is_found = *other.begin == phrase_begin + other.offset;
+            }
+            if (is_found) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool SearchServer::SatisfiesRequirements(const Query& query, int document_id) const {
+        const auto& word_freqs = GetWordFrequencies(document_id);
+        if (!std::all_of(query.required_words.begin(), query.required_words.end(),
+                [&word_freqs](std::string_view word) {
+                    return word_freqs.count(word) > 0;
+                })) {
+            return false;
+        }
+        if (query.phrases.empty()) {
+            return true;
+        }
+        const DocumentPositions& positions = document_positions_[GetDocumentSlot(document_id)];
+        std::vector<PhraseWordPositions> phrase_positions;
+        return std::all_of(query.phrases.begin(), query.phrases.end(),
+            [&](const Phrase& phrase) {
+                return ContainsPhrase(positions, phrase, phrase_positions);
+            });
     }
 
     int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -128,39 +1074,160 @@
         return rating_sum / static_cast<int>(ratings.size());
     }
 
-    SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string& text) const {
+    int SearchServer::AllocateSlot(int document_id, int rating, DocumentStatus status) {
+        int slot = document_ids_.size();
+        if (free_slots_.empty()) {
+            document_ids_.push_back(document_id);
+            document_ratings_.push_back(rating);
+            document_statuses_.push_back(status);
+        } else {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            document_ids_[slot] = document_id;
+            document_ratings_[slot] = rating;
+            document_statuses_[slot] = status;
+        }
+        ++status_document_counts_[static_cast<size_t>(status)];
+        document_slots_.emplace(document_id, slot);
+        return slot;
+    }
+
+    void SearchServer::ReleaseSlot(int slot) {
+        --status_document_counts_[static_cast<size_t>(document_statuses_[slot])];
+        document_ids_[slot] = NO_DOCUMENT_ID;
+        free_slots_.push_back(slot);
+    }
+
+    int SearchServer::GetDocumentSlot(int document_id) const {
+        return document_slots_.at(document_id);
+    }
+
+    SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
         if (text.empty()) {
             throw std::invalid_argument("Query word is empty"s);
         }
-        std::string word = text;
+        std::string_view word = text;
         bool is_minus = false;
+        bool is_required = false;
         if (word[0] == '-') {
             is_minus = true;
-            word = word.substr(1);
+            word.remove_prefix(1);
+        } else if (word[0] == '+') {
+            is_required = true;
+            word.remove_prefix(1);
         }
-        if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-            throw std::invalid_argument("Query word "s + text + " is invalid");
+        if (word.empty() || word[0] == '-' || word[0] == '+' || !IsValidWord(word)) {
+            throw std::invalid_argument("Query word "s + std::string(text) + " is invalid");
         }
 
-        return {word, is_minus, IsStopWord(word)};
+        return {word, is_minus, is_required, IsStopWord(word)};
     }
 
-    SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
+    SearchServer::Query SearchServer::ParseQuery(std::string_view text, bool deduplicate) const {
+        STATS_SCOPED_TIMER("ParseQuery"s);
         Query result;
-        for (const std::string& word : SplitIntoWords(text)) {
+        // фраза открывается словом, начинающимся с кавычки, и закрывается словом, кончающимся ею.
+        // Внутри фразы слова берутся как есть, без минусов и плюсов
+        std::optional<Phrase> phrase;
+        uint32_t phrase_length = 0;
+        for (std::string_view word : SplitIntoWords(text)) {
+            if (!phrase && word[0] == '"') {
+                phrase.emplace();
+                phrase_length = 0;
+                word.remove_prefix(1);
+            }
+            if (phrase) {
+                const bool is_phrase_end = !word.empty() && word.back() == '"';
+                if (is_phrase_end) {
+                    word.remove_suffix(1);
+                }
+                if (!word.empty()) {
+                    if (!IsValidWord(word)) {
+                        throw std::invalid_argument("Query word "s + std::string(word) + " is invalid");
+                    }
+                    if (!IsStopWord(word)) {
+                        phrase->push_back({word, phrase_length});
+                    }
+                    ++phrase_length;
+                }
+                if (is_phrase_end) {
+                    if (phrase_length == 0) {
+                        throw std::invalid_argument("Query phrase is empty"s);
+                    }
+                    AddQueryPhrase(result, std::move(*phrase));
+                    phrase.reset();
+                }
+                continue;
+            }
             const auto query_word = ParseQueryWord(word);
             if (!query_word.is_stop) {
                 if (query_word.is_minus) {
-                    result.minus_words.insert(query_word.data);
+                    result.minus_words.push_back(query_word.data);
                 } else {
-                    result.plus_words.insert(query_word.data);
+                    result.plus_words.push_back(query_word.data);
+                    if (query_word.is_required) {
+                        result.required_words.push_back(query_word.data);
+                    }
                 }
             }
         }
+        if (phrase) {
+            throw std::invalid_argument("Query phrase is not closed"s);
+        }
+        if (deduplicate) {
+            for (auto* words : {&result.plus_words, &result.minus_words, &result.required_words}) {
+                std::sort(words->begin(), words->end());
+                words->erase(std::unique(words->begin(), words->end()), words->end());
+            }
+            std::sort(result.phrases.begin(), result.phrases.end());
+            result.phrases.erase(std::unique(result.phrases.begin(), result.phrases.end()), result.phrases.end());
+        }
         return result;
     }
 
-    // Existence required
-    double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const {
-        return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+    void SearchServer::AddQueryPhrase(Query& query, Phrase phrase) const {
+        if (phrase.empty()) {
+            return;
+        }
+        // стоп-слова в начале фразы ничего не ограничивают
+        const uint32_t first_offset = phrase.front().second;
+        for (auto& [word, offset] : phrase) {
+            offset -= first_offset;
+            query.plus_words.push_back(word);
+            query.required_words.push_back(word);
+        }
+        if (phrase.size() > 1) {
+            if (!positional_index_) {
+                throw std::invalid_argument("Phrase queries require the positional index"s);
+            }
+            query.phrases.push_back(std::move(phrase));
+        }
+    }
+
+    double SearchServer::ComputeInverseDocumentFreq(int document_count, size_t document_freq) {
+        return log(document_count * 1.0 / document_freq);
+    }
+
+    double SearchServer::GetWordInverseDocumentFreq(const WordIndex& word_index) const {
+        // idf записывается раньше idf_epoch, поэтому совпавшая эпоха гарантирует, что idf посчитан в ней
+        if (word_index.idf_epoch.load(std::memory_order_acquire) == epoch_) {
+            return word_index.idf.load(std::memory_order_relaxed);
+        }
+        const double idf = ComputeInverseDocumentFreq(GetDocumentCount(), word_index.postings.size());
+        word_index.idf.store(idf, std::memory_order_relaxed);
+        word_index.idf_epoch.store(epoch_, std::memory_order_release);
+        return idf;
+    }
+
+    SearchServer::WordIndex::WordIndex(PostingList word_postings)
+        : postings(std::move(word_postings))
+    {
+    }
+
+    SearchServer::WordIndex::WordIndex(const WordIndex& other)
+        : postings(other.postings)
+        , idf_epoch(other.idf_epoch.load(std::memory_order_acquire))
+        , idf(other.idf.load(std::memory_order_relaxed))
+        , unverified_postings(other.unverified_postings.load(std::memory_order_acquire))
+    {
     }
\ No newline at end of file
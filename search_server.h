@@ -1,14 +1,79 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <exception>
+#include <execution>
+#include <istream>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <string_view>
 
 #include "document.h"
+#include "instrumentation.h"
+#include "pipeline.h"
+#include "posting_list.h"
+#include "query_cache.h"
+#include "score_accumulator.h"
 #include "string_processing.h"
 
 using namespace std::string_literals;
 
-const int MAX_RESULT_DOCUMENT_COUNT = 5;
+const size_t DEFAULT_RESULT_DOCUMENT_COUNT = 5;
+
+// Релевантности, различающиеся меньше чем на RELEVANCE_EPSILON, считаются равными
+const double RELEVANCE_EPSILON = 1e-6;
+
+// Как отбираются лучшие документы выдачи
+enum class TopDocumentsAlgorithm {
+    // релевантность считается для всех документов с плюс-словами
+    EXHAUSTIVE,
+    // WAND: документы обходятся по возрастанию, а документ, которому даже при наибольших частотах
+    // его слов не попасть в окно выдачи, пропускается без чтения его вхождений и данных.
+    // Выдача та же, что у EXHAUSTIVE; выигрыш растёт с частотой слов запроса и падает с размером окна
+    WAND,
+};
+
+// Какое окно отсортированной выдачи вернуть: count документов, пропустив первые offset
+struct SearchOptions {
+    size_t count = DEFAULT_RESULT_DOCUMENT_COUNT;
+    size_t offset = 0;
+    TopDocumentsAlgorithm algorithm = TopDocumentsAlgorithm::EXHAUSTIVE;
+};
+
+enum class DuplicateMode {
+    // дубликаты добавляются как обычные документы
+    ALLOW,
+    // AddDocument и AddDocuments отвергают документ с тем же набором слов, что у уже добавленного
+    REJECT,
+};
+
+// Параметры конвейерной загрузки документов
+struct BulkLoadOptions {
+    // столько документов читается, разбирается на слова и сливается в индекс за раз
+    size_t batch_size = 1024;
+    // столько пачек может одновременно находиться в конвейере; ограничивает память загрузки
+    size_t max_batches_in_flight = 16;
+    // потоки разбора на слова; 0 - по числу ядер
+    size_t tokenizer_threads = 0;
+};
+
+// Минимальное число документов в одном шарде при параллельном подсчёте релевантности
+const size_t MIN_DOCUMENTS_PER_SHARD = 2048;
+
+// Политики выполнения, для которых у сервера есть реализации: std::execution::seq и std::execution::par
+template <typename ExecutionPolicy>
+inline constexpr bool IS_SUPPORTED_EXECUTION_POLICY =
+    std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>
+    || std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>;
 
 class SearchServer {
 public:
@@ -17,71 +82,458 @@ public:
 
     explicit SearchServer(const std::string& stop_words_text);
 
-    void AddDocument(int document_id, const std::string& document, DocumentStatus status,
+    explicit SearchServer(std::string_view stop_words_text);
+
+    // Частоты слов по документам ссылаются на строки словаря, поэтому копия перестраивает эти ссылки
+    SearchServer(const SearchServer& other);
+
+    SearchServer(SearchServer&& other) = default;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
                      const std::vector<int>& ratings);
 
+    // Синтаксис запроса: слово - плюс-слово, "-слово" - минус-слово, "+слово" - слово, которое документ
+    // выдачи обязан содержать, "слова в кавычках" - фраза: её слова обязательны и должны идти в документе
+    // подряд. Стоп-слово во фразе совпадает с любым словом на своём месте. Обязательные слова и слова фраз
+    // входят в релевантность как плюс-слова, а выдача ищется пересечением их списков вхождений, так что
+    // запрос с ними не дороже запроса из одних плюс-слов
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query,
-                                      DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                      DocumentPredicate document_predicate, SearchOptions options = {}) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                      SearchOptions options = {}) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, SearchOptions options = {}) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                      DocumentPredicate document_predicate, SearchOptions options = {}) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                      DocumentStatus status, SearchOptions options = {}) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                      SearchOptions options = {}) const;
+
+    // Добавляет документы конвейером: чтение, разбор на слова и слияние в индекс идут в разных
+    // потоках, каждая пачка разбирается в свой частичный индекс. Результат тот же, что у AddDocument
+    // для документов по порядку: при ошибке документы до ошибочного остаются добавленными,
+    // а исключение пробрасывается вызывающему
+    void AddDocuments(std::vector<DocumentRecord> documents, const BulkLoadOptions& options = {});
+
+    // Документы читаются построчно в формате ReadDocumentRecord
+    void AddDocuments(std::istream& input, const BulkLoadOptions& options = {});
+
+    // В режиме REJECT сервер хранит отпечатки наборов слов всех документов,
+    // и проверка нового документа стоит O(число его различных слов)
+    void SetDuplicateMode(DuplicateMode mode);
+
+    DuplicateMode GetDuplicateMode() const;
+
+    // Включает хранение позиций слов в документах, без которого запросы с фразами отвергаются.
+    // Текст документов не хранится, поэтому включить его можно только у сервера без документов
+    void EnablePositionalIndex();
+
+    bool HasPositionalIndex() const;
+
+    // Отпечаток набора различных слов документа; у документов с одинаковыми наборами слов
+    // отпечатки равны, у разных почти наверняка различаются
+    uint64_t GetDocumentFingerprint(int document_id) const;
+
+    // Включает кеш выдач FindTopDocuments с фильтром по статусу. Ключ - разобранный запрос
+    // с отсортированными словами и фразами, статус, окно выдачи и алгоритм отбора, так что
+    // порядок и повторы слов запроса не дробят кеш. Любое изменение индекса сбрасывает кеш
+    void EnableQueryCache(size_t memory_budget);
 
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status) const;
+    void DisableQueryCache();
 
-    std::vector<Document> FindTopDocuments(const std::string& raw_query) const;
+    // У выключенного кеша вся статистика нулевая
+    QueryCacheStats GetQueryCacheStats() const;
+
+    // Число документов и слов индекса и метрики горячих путей: время разбора запроса, подсчёта
+    // релевантности и выбора окна, число просмотренных вхождений, принятых и отсеянных минус-словами документов.
+    // Таймеры и счётчики общие для всех серверов процесса
+    std::string GetStats(StatsFormat format = StatsFormat::TEXT) const;
+
+    // Сжимает списки вхождений всех слов (см. PostingList::Compress). Выдача не меняется.
+    // Список, в который потом добавляют или из которого удаляют документ, распаковывается,
+    // так что после пачки изменений сжатие стоит повторить
+    void CompressPostings();
+
+    // Память под списки вхождений всех слов
+    size_t GetPostingsMemoryUsage() const;
+
+    // Память под позиции слов в документах
+    size_t GetPositionsMemoryUsage() const;
 
     int GetDocumentCount() const;
     
-    const std::map<std::string, double>& GetWordFrequencies(int document_id) const;
+    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
     
-    std::set<int>::const_iterator begin();
+    std::set<int>::const_iterator begin() const;
     
-    std::set<int>::const_iterator end();
+    std::set<int>::const_iterator end() const;
+
+    // Слова результата ссылаются на словарь сервера и действительны, пока слово есть в индексе
+    using MatchedWords = std::tuple<std::vector<std::string_view>, DocumentStatus>;
+
+    // Документ без какого-либо обязательного слова или фразы запроса не совпадает, как и документ с минус-словом
+    MatchedWords MatchDocument(std::string_view raw_query, int document_id) const;
+
+    MatchedWords MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const;
 
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
+    // Сначала параллельно проверяются минус-слова, и при совпадении плюс-слова уже не ищутся
+    MatchedWords MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const;
     
+    // Сохраняет стоп-слова, документы и инвертированный индекс в бинарный снимок.
+    // Сжатие списков вхождений в снимке не сохраняется
+    void SaveSnapshot(const std::string& path) const;
+
+    // Загружает сервер из снимка, записанного SaveSnapshot. Файл отображается в память и остаётся
+    // отображённым, пока жив сервер или его копии: списки вхождений, строки словаря и частоты слов
+    // по документам читаются прямо из отображения. Загрузка проверяет контрольную сумму оглавления
+    // и строит таблицу документов, словарь и, если он включён, позиционный индекс, так что она линейна
+    // по числу документов и слов и по числу позиций, но не по числу вхождений. Контрольная сумма
+    // списка вхождений слова проверяется при первом обращении к нему, частот слов документа -
+    // при первом GetWordFrequencies; испорченный блок даёт std::runtime_error в этом обращении
+    static SearchServer LoadSnapshot(const std::string& path);
+
+    // Удаление несуществующего документа ничего не делает
     void RemoveDocument(int document_id);
 
+    void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
+
+    // Документ удаляется из списков вхождений всех своих слов параллельно
+    void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+
 private:
-    struct DocumentData {
-        int rating;
+    static constexpr int NO_DOCUMENT_ID = -1;
+    static constexpr size_t DOCUMENT_STATUS_COUNT = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+
+    // Фильтр по одному статусу. Подсчёт релевантности распознаёт его среди предикатов: статус читается
+    // из столбца статусов раньше проверки минус-слов, а сам предикат не вызывается
+    struct StatusFilter {
         DocumentStatus status;
+
+        bool operator()(int, DocumentStatus document_status, int) const {
+            return document_status == status;
+        }
+    };
+
+    // Блоки списка вхождений слова в снимке индекса
+    struct SnapshotPostings;
+
+    // Отображённый в память снимок, из которого загружен сервер, общий для копий сервера
+    struct SnapshotIndex;
+
+    // Слово индекса: список вхождений и IDF, посчитанный при эпохе idf_epoch.
+    // IDF зависит только от числа документов и длины списка, а они меняются лишь вместе с epoch_,
+    // поэтому запрос пересчитывает IDF не чаще раза за эпоху. Константные запросы из разных потоков
+    // могут пересчитывать его одновременно: при одной эпохе все они записывают одно и то же значение
+    struct WordIndex {
+        static const uint64_t NO_EPOCH = UINT64_MAX;
+
+        PostingList postings;
+        mutable std::atomic<uint64_t> idf_epoch{NO_EPOCH};
+        mutable std::atomic<double> idf{0.0};
+        // у списка поверх снимка индекса, контрольная сумма которого ещё не проверена, - его блоки
+        mutable std::atomic<const SnapshotPostings*> unverified_postings{nullptr};
+
+        WordIndex() = default;
+
+        explicit WordIndex(PostingList word_postings);
+
+        WordIndex(const WordIndex& other);
+    };
+
+    // ключи словаря ссылаются на строки в отображённом снимке или в own_words_
+    using Dictionary = std::map<std::string_view, WordIndex>;
+
+    // Позиции слов документа - их номера среди всех слов текста, включая стоп-слова
+    struct DocumentPositions {
+        struct WordPositions {
+            // строка словаря; записи упорядочены по словам
+            std::string_view word;
+            // позиции слова занимают positions от конца позиций предыдущей записи до end
+            uint32_t end;
+        };
+
+        std::vector<WordPositions> words;
+        std::vector<uint32_t> positions;
     };
-    const std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
+
+    // Позиции одного слова фразы в документе и его смещение от начала фразы
+    struct PhraseWordPositions {
+        const uint32_t* begin;
+        const uint32_t* end;
+        uint32_t offset;
+    };
+
+    const std::set<std::string, std::less<>> stop_words_;
+    // снимок, из которого загружен сервер; без снимка nullptr
+    std::shared_ptr<SnapshotIndex> snapshot_;
+    // строки слов словаря, которых нет в снимке
+    std::set<std::string, std::less<>> own_words_;
+    // ключи словаря - единственная копия каждого слова, остальные структуры хранят string_view на них.
+    // Списки вхождений хранят не id документов, а их слоты
+    Dictionary word_to_document_freqs_;
+    // слоты - внутренние номера документов, плотно занимающие [0, document_ids_.size()),
+    // чтобы релевантность запроса копилась в массиве по слотам
+    std::map<int, int> document_slots_;
+    // данные документов по слотам, каждое поле - отдельным столбцом, чтобы проверка статуса
+    // читала байт на документ. NO_DOCUMENT_ID - у свободного слота
+    std::vector<int> document_ids_;
+    std::vector<int> document_ratings_;
+    std::vector<DocumentStatus> document_statuses_;
+    std::array<int, DOCUMENT_STATUS_COUNT> status_document_counts_{};
+    // слоты удалённых документов, их занимают следующие добавленные
+    std::vector<int> free_slots_;
     std::set<int> docs_ids_;
-    std::map<int,std::map<std::string, double>> word_freqs_ids_;
+    // частоты слов документов, добавленных после загрузки снимка; частоты документов снимка
+    // читаются из него (см. snapshot_slots_)
+    std::map<int,std::map<std::string_view, double>> word_freqs_ids_;
+    // по слотам: занят ли слот документом из снимка, ещё не удалённым
+    std::vector<bool> snapshot_slots_;
+    bool positional_index_ = false;
+    // по слотам; пусто без позиционного индекса
+    std::vector<DocumentPositions> document_positions_;
+    DuplicateMode duplicate_mode_ = DuplicateMode::ALLOW;
+    // документы по отпечаткам наборов слов; ведётся только в режиме DuplicateMode::REJECT
+    std::unordered_map<uint64_t, std::vector<int>> fingerprint_to_documents_;
+    // растёт при каждом изменении индекса
+    uint64_t epoch_ = 0;
+    std::unique_ptr<QueryResultCache> query_cache_;
+
+    bool IsStopWord(std::string_view word) const;
+
+    // Запись слова в словаре; новое слово добавляется с пустым списком вхождений
+    Dictionary::iterator FindOrAddWord(std::string_view word);
+
+    void EraseWord(Dictionary::iterator it);
+
+    // Проверяет контрольные суммы и порядок вхождений списка из снимка при первом обращении.
+    // Испорченный список - std::runtime_error
+    void VerifyPostings(const WordIndex& word_index) const;
 
-    bool IsStopWord(const std::string& word) const;
+    const PostingList& GetPostings(const WordIndex& word_index) const;
 
-    static bool IsValidWord(const std::string& word);
+    // Проверяет списки вхождений слов words, которые есть в словаре. Вызывается до изменения индекса,
+    // чтобы порча снимка обнаружилась раньше, чем индекс изменится наполовину
+    void VerifyPostings(const std::vector<std::string_view>& words) const;
 
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    // Частоты слов документа снимка в слоте slot, разобранные при первом обращении
+    const std::map<std::string_view, double>& GetSnapshotWordFrequencies(int slot) const;
+
+    static bool IsValidWord(std::string_view word);
+
+    // разбивает строку на слова, разделенные пробелами, вместе со стоп-словами
+    static std::vector<std::string_view> SplitIntoValidWords(std::string_view text);
+
+    void RemoveStopWords(std::vector<std::string_view>& words) const;
 
     //разбивает строку на слова, разделенные пробелами за вычетом стоп-слов
-    //std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+
+    // words - все слова текста по порядку; позиции ссылаются на них, а не на словарь
+    DocumentPositions IndexWordPositions(const std::vector<std::string_view>& words) const;
+
+    // Собирает позиции из пар слово - позиция в любом порядке
+    static DocumentPositions MakeDocumentPositions(std::vector<std::pair<std::string_view, uint32_t>> word_positions);
+
+    // Переводит слова positions на строки словаря и сохраняет их за слотом
+    void StoreDocumentPositions(int slot, DocumentPositions positions);
+
+    // Позиции слова в документе; пустой промежуток, если слова в нём нет
+    static std::pair<const uint32_t*, const uint32_t*> FindWordPositions(const DocumentPositions& positions,
+                                                                         std::string_view word);
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    int AllocateSlot(int document_id, int rating, DocumentStatus status);
+
+    void ReleaseSlot(int slot);
+
+    // Забывает частоты слов удаляемого документа из word_freqs_ids_ или из снимка
+    void ForgetWordFrequencies(int document_id, int slot);
+
+    int GetDocumentSlot(int document_id) const;
+
+    // Проверка документа до минус-слов: StatusFilter сверяет статус, остальные предикаты пропускают всё
+    template <typename DocumentPredicate>
+    bool PassesStatusFilter(const DocumentPredicate& document_predicate, int slot) const;
+
+    // Проверка документа после минус-слов: вызывает предикат, кроме уже проверенного StatusFilter
+    template <typename DocumentPredicate>
+    bool PassesPredicate(const DocumentPredicate& document_predicate, int slot) const;
+
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
+        bool is_required;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(const std::string& text) const;
+    QueryWord ParseQueryWord(std::string_view text) const;
+
+    // Слова фразы без стоп-слов и их смещения от первого слова
+    using Phrase = std::vector<std::pair<std::string_view, uint32_t>>;
 
     struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+        // вместе с обязательными словами и словами фраз
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
+        // вместе со словами фраз
+        std::vector<std::string_view> required_words;
+        // только фразы хотя бы из двух слов, остальные сводятся к обязательным словам
+        std::vector<Phrase> phrases;
+    };
+
+    // Добавляет к query слова фразы и саму фразу
+    void AddQueryPhrase(Query& query, Phrase phrase) const;
+
+    // Без deduplicate слова остаются в порядке запроса и могут повторяться
+    Query ParseQuery(std::string_view text, bool deduplicate = true) const;
+
+    static double ComputeInverseDocumentFreq(int document_count, size_t document_freq);
+
+    // IDF слова из закэшированного значения, если оно посчитано в текущую эпоху
+    double GetWordInverseDocumentFreq(const WordIndex& word_index) const;
+
+    static std::string MakeQueryCacheKey(const Query& query, DocumentStatus status, SearchOptions options);
+
+    // Есть ли в документе фраза; word_positions - память под позиции её слов, переиспользуемая между вызовами
+    static bool ContainsPhrase(const DocumentPositions& positions, const Phrase& phrase,
+                               std::vector<PhraseWordPositions>& word_positions);
+
+    // Содержит ли документ все обязательные слова и фразы запроса
+    bool SatisfiesRequirements(const Query& query, int document_id) const;
+
+    // inverse_document_freq(word, word_index) даёт IDF слова запроса по его записи в индексе;
+    // ShardedSearchServer подставляет сюда IDF по всем шардам
+    template <typename ExecutionPolicy, typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const Query& query,
+                                      DocumentPredicate document_predicate, SearchOptions options,
+                                      InverseDocumentFreq inverse_document_freq) const;
+
+    // Порядок выдачи: по убыванию релевантности, при равных релевантности и рейтинге - по возрастанию id,
+    // чтобы seq и par отдавали одно и то же
+    static bool RanksHigher(const Document& lhs, const Document& rhs);
+
+    // Сколько лучших документов нужно, чтобы составить окно options
+    static size_t GetWindowEnd(SearchOptions options);
+
+    // Оставляет в documents окно options выдачи, отсортированное по убыванию релевантности
+    template <typename ExecutionPolicy>
+    static void SelectResultWindow(ExecutionPolicy&& policy, std::vector<Document>& documents, SearchOptions options);
+
+    // words - отсортированные различные слова
+    static uint64_t ComputeWordSetFingerprint(const std::vector<std::string_view>& words);
+
+    // Документ с отпечатком fingerprint и набором слов words, если такой есть
+    std::optional<int> FindDocumentWithWords(uint64_t fingerprint, const std::vector<std::string_view>& words) const;
+
+    void ForgetFingerprint(int document_id);
+
+    // Пачка документов, разобранная на слова независимо от индекса.
+    // Слова ссылаются на тексты в records, которые пачка хранит сама
+    struct IndexedBatch {
+        struct WordPosting {
+            std::string_view word;
+            size_t document_index;
+            double term_freq;
+        };
+
+        std::vector<DocumentRecord> records;
+        // вхождения слов в документы records, упорядоченные по слову, затем по номеру документа
+        std::vector<WordPosting> postings;
+        // ошибка разбора документа records.size(), следующие документы отброшены
+        std::exception_ptr error;
+        // только в режиме DuplicateMode::REJECT: различные слова документов и их отпечатки
+        std::vector<std::vector<std::string_view>> document_words;
+        std::vector<uint64_t> fingerprints;
+        // только с позиционным индексом: позиции слов документов, ссылаются на тексты records
+        std::vector<DocumentPositions> positions;
     };
 
-    Query ParseQuery(const std::string& text) const;
+    IndexedBatch IndexBatch(std::vector<DocumentRecord> records) const;
+
+    void MergeBatch(IndexedBatch batch);
 
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    template <typename DocumentReader>
+    void AddDocumentsPipelined(DocumentReader read_document, const BulkLoadOptions& options);
+
+    // Списки вхождений слов запроса, которые есть в индексе, у плюс-слов - вместе с их IDF
+    struct QueryPostings {
+        std::vector<std::pair<const PostingList*, double>> plus_postings;
+        std::vector<const PostingList*> minus_postings;
+        // по возрастанию длины
+        std::vector<const PostingList*> required_postings;
+        const std::vector<Phrase>* phrases = nullptr;
+        // какого-то обязательного слова нет ни в одном документе, и выдача пуста
+        bool is_unsatisfiable = false;
+    };
+
+    template <typename InverseDocumentFreq>
+    QueryPostings FindQueryPostings(const Query& query, InverseDocumentFreq inverse_document_freq) const;
+
+    // Дописывает в matched_documents документы со слотами из [lower, upper) и их релевантность.
+    // Минус-слова проверяются при первом касании документа, до предиката и подсчёта релевантности,
+    // так что отсеянные документы не читаются и не считаются. Документы одного плюс-слова идут
+    // по возрастанию слотов, поэтому курсоры минус-слов идут галопом вперёд и длинные списки
+    // минус-слов читаются лишь в окрестностях документов плюс-слов
+    template <typename DocumentPredicate>
+    void ScoreDocuments(const QueryPostings& postings, int64_t lower, int64_t upper,
+                        DocumentPredicate document_predicate, std::vector<Document>& matched_documents) const;
 
+    // То же для запроса с обязательными словами. Кандидаты - пересечение их списков: курсор самого короткого
+    // предлагает документ, остальные перескакивают к нему галопом, а промахнувшийся предлагает свой следующий.
+    // Плюс- и минус-слова и фразы проверяются только у кандидатов, а релевантность складывается в том же
+    // порядке, что у ScoreDocuments, без накопителя по слотам, так что память не растёт с числом документов
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query,
-                                      DocumentPredicate document_predicate) const;
+    void IntersectDocuments(const QueryPostings& postings, int64_t lower, int64_t upper,
+                            DocumentPredicate document_predicate, std::vector<Document>& matched_documents) const;
+
+    // Дописывает в top_documents не больше top_count лучших документов со слотами из [lower, upper).
+    // Курсоры плюс-слов упорядочиваются по текущему документу, и опорным становится первый документ,
+    // на котором сумма оценок сверху вклада слов (наибольшая частота на IDF) курсоров до него включительно
+    // может дотянуть до худшего из найденных лучших. Курсоры до опорного перескакивают к нему галопом,
+    // а сам он считается полностью, складывая вклады слов в порядке запроса, как ScoreDocuments
+    template <typename DocumentPredicate>
+    void CollectTopDocuments(const QueryPostings& postings, int64_t lower, int64_t upper,
+                             DocumentPredicate document_predicate, size_t top_count,
+                             std::vector<Document>& top_documents) const;
+
+    // Делит документы на шарды по диапазонам слотов и вызывает score_shard(lower, upper, documents)
+    // для каждого шарда отдельной задачей. Шард считается по всем словам запроса в том же порядке,
+    // что и последовательная версия, поэтому релевантности совпадают с ней до бита и блокировки не нужны
+    template <typename ShardScorer>
+    std::vector<Document> ScoreShards(const QueryPostings& postings, ShardScorer score_shard) const;
+
+    template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query,
+                                      DocumentPredicate document_predicate,
+                                      InverseDocumentFreq inverse_document_freq) const;
+
+    template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query,
+                                      DocumentPredicate document_predicate,
+                                      InverseDocumentFreq inverse_document_freq) const;
+
+    // Не больше top_count документов, среди которых top_count лучших по RanksHigher
+    template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> FindTopCandidates(const std::execution::sequenced_policy&, const Query& query,
+                                      DocumentPredicate document_predicate, size_t top_count,
+                                      InverseDocumentFreq inverse_document_freq) const;
+
+    template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> FindTopCandidates(const std::execution::parallel_policy&, const Query& query,
+                                      DocumentPredicate document_predicate, size_t top_count,
+                                      InverseDocumentFreq inverse_document_freq) const;
+
+    friend class ShardedSearchServer;
 };
 
 template<typename StringContainer>
@@ -93,58 +545,542 @@ template<typename StringContainer>
         }
     }
 
+template <typename DocumentReader>
+    void SearchServer::AddDocumentsPipelined(DocumentReader read_document, const BulkLoadOptions& options) {
+        const size_t tokenizer_threads = options.tokenizer_threads > 0
+            ? options.tokenizer_threads
+            : std::max(std::thread::hardware_concurrency(), 1u);
+        // ошибка чтения откладывается, чтобы прочитанные до неё документы успели попасть в индекс
+        std::exception_ptr read_error;
+        RunOrderedPipeline<std::vector<DocumentRecord>, IndexedBatch>(
+            [&](std::vector<DocumentRecord>& records) {
+                if (read_error) {
+                    std::rethrow_exception(read_error);
+                }
+                records.reserve(options.batch_size);
+                DocumentRecord record;
+                try {
+                    while (records.size() < std::max<size_t>(options.batch_size, 1) && read_document(record)) {
+                        records.push_back(std::move(record));
+                    }
+                } catch (...) {
+                    read_error = std::current_exception();
+                    if (records.empty()) {
+                        throw;
+                    }
+                }
+                return !records.empty();
+            },
+            [this](std::vector<DocumentRecord> records) {
+                return IndexBatch(std::move(records));
+            },
+            [this](IndexedBatch batch) {
+                MergeBatch(std::move(batch));
+            },
+            tokenizer_threads, options.max_batches_in_flight);
+    }
+
 template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query,
-                                      DocumentPredicate document_predicate) const {
+    std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
+                                      DocumentPredicate document_predicate, SearchOptions options) const {
+        return FindTopDocuments(std::execution::seq, raw_query, document_predicate, options);
+    }
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                      DocumentPredicate document_predicate, SearchOptions options) const {
+        static_assert(IS_SUPPORTED_EXECUTION_POLICY<ExecutionPolicy>,
+                      "FindTopDocuments supports only std::execution::seq and std::execution::par");
+        return FindTopDocuments(policy, SearchServer::ParseQuery(raw_query), document_predicate, options,
+            [this](std::string_view, const WordIndex& word_index) {
+                return SearchServer::GetWordInverseDocumentFreq(word_index);
+            });
+    }
+
+template <typename ExecutionPolicy, typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const Query& query,
+                                      DocumentPredicate document_predicate, SearchOptions options,
+                                      InverseDocumentFreq inverse_document_freq) const {
+        STATS_SCOPED_TIMER("FindTopDocuments"s);
+        if constexpr (std::is_same_v<DocumentPredicate, StatusFilter>) {
+            // ни один документ не подходит по статусу, и списки вхождений не читаются
+            if (status_document_counts_[static_cast<size_t>(document_predicate.status)] == 0) {
+                return {};
+            }
+        }
+        auto matched_documents = options.algorithm == TopDocumentsAlgorithm::WAND
+            ? SearchServer::FindTopCandidates(policy, query, document_predicate, GetWindowEnd(options),
+                                              inverse_document_freq)
+            : SearchServer::FindAllDocuments(policy, query, document_predicate, inverse_document_freq);
+        SelectResultWindow(policy, matched_documents, options);
+        STATS_COUNTER_ADD("documents_returned"s, matched_documents.size());
+        return matched_documents;
+    }
+
+template <typename ExecutionPolicy>
+    void SearchServer::SelectResultWindow(ExecutionPolicy&& policy, std::vector<Document>& matched_documents,
+                                          SearchOptions options) {
+        STATS_SCOPED_TIMER("SelectResultWindow"s);
+        const size_t window_begin = std::min(options.offset, matched_documents.size());
+        const size_t window_end = window_begin + std::min(options.count, matched_documents.size() - window_begin);
+        if (window_begin == window_end) {
+            matched_documents.clear();
+            return;
+        }
+
+        // упорядочивается только запрошенное окно: nth_element отсекает пропускаемые документы,
+        // partial_sort сортирует окно, не трогая хвост выдачи
+        const auto first = matched_documents.begin();
+        if (window_begin > 0) {
+            std::nth_element(policy, first, first + window_begin, matched_documents.end(), RanksHigher);
+        }
+        std::partial_sort(policy, first + window_begin, first + window_end, matched_documents.end(), RanksHigher);
+
+        matched_documents.erase(first + window_end, matched_documents.end());
+        matched_documents.erase(matched_documents.begin(), matched_documents.begin() + window_begin);
+    }
+
+template <typename ExecutionPolicy>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                      DocumentStatus status, SearchOptions options) const {
+        static_assert(IS_SUPPORTED_EXECUTION_POLICY<ExecutionPolicy>,
+                      "FindTopDocuments supports only std::execution::seq and std::execution::par");
+        const StatusFilter by_status{status};
+        if (!query_cache_) {
+            return FindTopDocuments(policy, raw_query, by_status, options);
+        }
         const auto query = SearchServer::ParseQuery(raw_query);
+        std::string key = MakeQueryCacheKey(query, status, options);
+        if (auto cached = query_cache_->Find(key, epoch_)) {
+            return std::move(*cached);
+        }
+        auto result = FindTopDocuments(policy, query, by_status, options,
+            [this](std::string_view, const WordIndex& word_index) {
+                return SearchServer::GetWordInverseDocumentFreq(word_index);
+            });
+        query_cache_->Insert(std::move(key), result, epoch_);
+        return result;
+    }
+
+template <typename ExecutionPolicy>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                      SearchOptions options) const {
+        static_assert(IS_SUPPORTED_EXECUTION_POLICY<ExecutionPolicy>,
+                      "FindTopDocuments supports only std::execution::seq and std::execution::par");
+        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL, options);
+    }
 
-        auto matched_documents = SearchServer::FindAllDocuments(query, document_predicate);
+template <typename InverseDocumentFreq>
+    SearchServer::QueryPostings SearchServer::FindQueryPostings(const Query& query,
+                                      InverseDocumentFreq inverse_document_freq) const {
+        QueryPostings postings;
+        for (const std::string_view word : query.plus_words) {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it != word_to_document_freqs_.end()) {
+                postings.plus_postings.push_back({&GetPostings(it->second), inverse_document_freq(word, it->second)});
+            }
+        }
+        for (const std::string_view word : query.minus_words) {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it != word_to_document_freqs_.end()) {
+                postings.minus_postings.push_back(&GetPostings(it->second));
+            }
+        }
+        for (const std::string_view word : query.required_words) {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it == word_to_document_freqs_.end()) {
+                postings.is_unsatisfiable = true;
+                return postings;
+            }
+            postings.required_postings.push_back(&GetPostings(it->second));
+        }
+        std::sort(postings.required_postings.begin(), postings.required_postings.end(),
+            [](const PostingList* lhs, const PostingList* rhs) {
+                return lhs->size() < rhs->size();
+            });
+        postings.phrases = &query.phrases;
+        return postings;
+    }
 
-        sort(matched_documents.begin(), matched_documents.end(),
-             [](const Document& lhs, const Document& rhs) {
-                 if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-                     return lhs.rating > rhs.rating;
-                 } else {
-                     return lhs.relevance > rhs.relevance;
-                 }
-             });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename DocumentPredicate>
+    bool SearchServer::PassesStatusFilter(const DocumentPredicate& document_predicate, int slot) const {
+        if constexpr (std::is_same_v<DocumentPredicate, StatusFilter>) {
+            return document_statuses_[slot] == document_predicate.status;
+        } else {
+            return true;
         }
+    }
 
-        return matched_documents;
+template <typename DocumentPredicate>
+    bool SearchServer::PassesPredicate(const DocumentPredicate& document_predicate, int slot) const {
+        if constexpr (std::is_same_v<DocumentPredicate, StatusFilter>) {
+            return true;
+        } else {
+            return document_predicate(document_ids_[slot], document_statuses_[slot], document_ratings_[slot]);
+        }
+    }
+
+template <typename DocumentPredicate>
+    void SearchServer::ScoreDocuments(const QueryPostings& postings, int64_t lower, int64_t upper,
+                                      DocumentPredicate document_predicate,
+                                      std::vector<Document>& matched_documents) const {
+        if (postings.is_unsatisfiable || !postings.required_postings.empty()) {
+            IntersectDocuments(postings, lower, upper, document_predicate, matched_documents);
+            return;
+        }
+        STATS_SCOPED_TIMER("ScorePostings"s);
+        const auto accumulator = ScoreAccumulator::Acquire(document_ids_.size());
+        std::vector<PostingList::Cursor> minus_cursors;
+        minus_cursors.reserve(postings.minus_postings.size());
+        for (const PostingList* minus_postings : postings.minus_postings) {
+            minus_cursors.emplace_back(*minus_postings);
+        }
+        size_t documents_scored = 0;
+        [[maybe_unused]] size_t documents_excluded = 0;
+        const auto accept = [&](int slot) {
+            if (!PassesStatusFilter(document_predicate, slot)) {
+                return false;
+            }
+            for (PostingList::Cursor& minus_cursor : minus_cursors) {
+                if (minus_cursor.SkipTo(slot)) {
+                    ++documents_excluded;
+                    return false;
+                }
+            }
+            const bool accepted = PassesPredicate(document_predicate, slot);
+            documents_scored += accepted;
+            return accepted;
+        };
+
+        [[maybe_unused]] size_t postings_scanned = 0;
+        for (size_t word_index = 0; word_index < postings.plus_postings.size(); ++word_index) {
+            const auto& [word_postings, inverse_document_freq] = postings.plus_postings[word_index];
+            if (word_index > 0) {
+                // слоты следующего слова снова идут от начала диапазона
+                for (size_t i = 0; i < minus_cursors.size(); ++i) {
+                    minus_cursors[i] = PostingList::Cursor(*postings.minus_postings[i]);
+                }
+            }
+            postings_scanned += word_postings->ForEachInRange(lower, upper, [&](int slot, double term_freq) {
+                accumulator->Add(slot, term_freq * inverse_document_freq, accept);
+            });
+        }
+        STATS_COUNTER_ADD("postings_scanned"s, postings_scanned);
+        STATS_COUNTER_ADD("documents_scored"s, documents_scored);
+        STATS_COUNTER_ADD("documents_excluded"s, documents_excluded);
+
+        matched_documents.reserve(matched_documents.size() + documents_scored);
+        accumulator->ForEachAccepted([&](int slot, double relevance) {
+            matched_documents.push_back({document_ids_[slot], relevance, document_ratings_[slot]});
+        });
     }
 
 template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindAllDocuments(const Query& query,
-                                      DocumentPredicate document_predicate) const {
-        std::map<int, double> document_to_relevance;
-        for (const std::string& word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+    void SearchServer::IntersectDocuments(const QueryPostings& postings, int64_t lower, int64_t upper,
+                                          DocumentPredicate document_predicate,
+                                          std::vector<Document>& matched_documents) const {
+        STATS_SCOPED_TIMER("IntersectPostings"s);
+        if (postings.is_unsatisfiable) {
+            return;
+        }
+        const int first_slot = static_cast<int>(std::max<int64_t>(lower, 0));
+        std::vector<PostingList::Cursor> required_cursors;
+        required_cursors.reserve(postings.required_postings.size());
+        for (const PostingList* required_postings : postings.required_postings) {
+            required_cursors.emplace_back(*required_postings);
+        }
+        std::vector<PostingList::Cursor> plus_cursors;
+        plus_cursors.reserve(postings.plus_postings.size());
+        for (const auto& [word_postings, _] : postings.plus_postings) {
+            plus_cursors.emplace_back(*word_postings);
+        }
+        std::vector<PostingList::Cursor> minus_cursors;
+        minus_cursors.reserve(postings.minus_postings.size());
+        for (const PostingList* minus_postings : postings.minus_postings) {
+            minus_cursors.emplace_back(*minus_postings);
+        }
+        std::vector<PhraseWordPositions> phrase_positions;
+
+        [[maybe_unused]] size_t postings_scanned = 0;
+        [[maybe_unused]] size_t documents_scored = 0;
+        [[maybe_unused]] size_t documents_excluded = 0;
+        PostingList::Cursor& shortest = required_cursors.front();
+        shortest.SkipTo(first_slot);
+        while (!shortest.AtEnd() && shortest.GetDocumentId() < upper) {
+            const int slot = shortest.GetDocumentId();
+            ++postings_scanned;
+            size_t missed = 1;
+            while (missed < required_cursors.size() && required_cursors[missed].SkipTo(slot)) {
+                ++missed;
+            }
+            postings_scanned += missed - 1;
+            if (missed < required_cursors.size()) {
+                // следующий кандидат - не раньше документа, на котором остановился промахнувшийся курсор
+                if (required_cursors[missed].AtEnd()) {
+                    break;
+                }
+                shortest.SkipTo(required_cursors[missed].GetDocumentId());
+                continue;
+            }
+            shortest.Next();
+
+            if (!PassesStatusFilter(document_predicate, slot)) {
+                continue;
+            }
+            const bool is_excluded = std::any_of(minus_cursors.begin(), minus_cursors.end(),
+                [slot](PostingList::Cursor& minus_cursor) {
+                    return minus_cursor.SkipTo(slot);
+                });
+            if (is_excluded) {
+                ++documents_excluded;
+                continue;
+            }
+            if (!PassesPredicate(document_predicate, slot)) {
                 continue;
             }
-            const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+            // позиции читаются последними: это самая дорогая проверка
+            if (!postings.phrases->empty()) {
+                const DocumentPositions& positions = document_positions_[slot];
+                if (!std::all_of(postings.phrases->begin(), postings.phrases->end(),
+                        [&](const Phrase& phrase) {
+                            return ContainsPhrase(positions, phrase, phrase_positions);
+                        })) {
+                    continue;
                 }
             }
+            ++documents_scored;
+            double relevance = 0.0;
+            for (size_t i = 0; i < plus_cursors.size(); ++i) {
+                if (plus_cursors[i].SkipTo(slot)) {
+                    relevance += plus_cursors[i].GetTermFreq() * postings.plus_postings[i].second;
+                }
+            }
+            matched_documents.push_back({document_ids_[slot], relevance, document_ratings_[slot]});
+        }
+        STATS_COUNTER_ADD("postings_scanned"s, postings_scanned);
+        STATS_COUNTER_ADD("documents_scored"s, documents_scored);
+        STATS_COUNTER_ADD("documents_excluded"s, documents_excluded);
+    }
+
+template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query,
+                                      DocumentPredicate document_predicate,
+                                      InverseDocumentFreq inverse_document_freq) const {
+        std::vector<Document> matched_documents;
+        ScoreDocuments(FindQueryPostings(query, inverse_document_freq), INT64_MIN, INT64_MAX,
+                       document_predicate, matched_documents);
+        return matched_documents;
+    }
+
+template <typename DocumentPredicate>
+    void SearchServer::CollectTopDocuments(const QueryPostings& postings, int64_t lower, int64_t upper,
+                                           DocumentPredicate document_predicate, size_t top_count,
+                                           std::vector<Document>& top_documents) const {
+        if (top_count == 0) {
+            return;
+        }
+        if (postings.is_unsatisfiable || !postings.required_postings.empty()) {
+            // выдача пересечения обычно мала, и лучшие из неё выбираются уже после подсчёта
+            const size_t documents_begin = top_documents.size();
+            IntersectDocuments(postings, lower, upper, document_predicate, top_documents);
+            if (top_documents.size() - documents_begin > top_count) {
+                const auto first = top_documents.begin() + documents_begin;
+                std::nth_element(first, first + top_count, top_documents.end(), RanksHigher);
+                top_documents.erase(first + top_count, top_documents.end());
+            }
+            return;
+        }
+        STATS_SCOPED_TIMER("ScorePostings"s);
+        struct TermCursor {
+            PostingList::Cursor cursor;
+            double inverse_document_freq;
+            // наибольший вклад слова в релевантность документа
+            double upper_bound;
+        };
+        const int first_slot = static_cast<int>(std::max<int64_t>(lower, 0));
+        // курсоры плюс-слов в порядке запроса
+        std::vector<TermCursor> terms;
+        terms.reserve(postings.plus_postings.size());
+        for (const auto& [word_postings, inverse_document_freq] : postings.plus_postings) {
+            terms.push_back({PostingList::Cursor(*word_postings), inverse_document_freq,
+                             word_postings->GetMaxTermFreq() * inverse_document_freq});
+            terms.back().cursor.SkipTo(first_slot);
+        }
+        std::vector<PostingList::Cursor> minus_cursors;
+        minus_cursors.reserve(postings.minus_postings.size());
+        for (const PostingList* minus_postings : postings.minus_postings) {
+            minus_cursors.emplace_back(*minus_postings);
+        }
+        const auto is_active = [upper](const TermCursor& term) {
+            return !term.cursor.AtEnd() && term.cursor.GetDocumentId() < upper;
+        };
+        std::vector<TermCursor*> active_terms;
+        for (TermCursor& term : terms) {
+            active_terms.push_back(&term);
         }
 
-        for (const std::string& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+        // лучшие найденные документы; в вершине кучи худший из них
+        std::vector<Document> heap;
+        [[maybe_unused]] size_t postings_scanned = 0;
+        [[maybe_unused]] size_t documents_scored = 0;
+        [[maybe_unused]] size_t documents_excluded = 0;
+        while (true) {
+            active_terms.erase(std::remove_if(active_terms.begin(), active_terms.end(),
+                [&is_active](const TermCursor* term) {
+                    return !is_active(*term);
+                }), active_terms.end());
+            std::sort(active_terms.begin(), active_terms.end(), [](const TermCursor* lhs, const TermCursor* rhs) {
+                return lhs->cursor.GetDocumentId() < rhs->cursor.GetDocumentId();
+            });
+
+            // документ может попасть в выдачу, если его релевантность не меньше худшей из лучших за вычетом
+            // допуска равенства; запас в ещё один допуск покрывает ошибки округления оценок сверху
+            const bool is_heap_full = heap.size() == top_count;
+            const double threshold = is_heap_full ? heap.front().relevance - 2 * RELEVANCE_EPSILON : 0.0;
+            size_t pivot = 0;
+            if (is_heap_full) {
+                double upper_bound = 0.0;
+                while (pivot < active_terms.size() && (upper_bound += active_terms[pivot]->upper_bound) < threshold) {
+                    ++pivot;
+                }
+            }
+            if (pivot == active_terms.size()) {
+                break;
+            }
+            const int pivot_slot = active_terms[pivot]->cursor.GetDocumentId();
+            // в опорный документ могут входить слова всех курсоров до pivot_end
+            size_t pivot_end = pivot + 1;
+            while (pivot_end < active_terms.size() && active_terms[pivot_end]->cursor.GetDocumentId() == pivot_slot) {
+                ++pivot_end;
+            }
+            if (is_heap_full) {
+                // оценка по наибольшим частотам в диапазоне опорного документа (block-max); если и её не хватает,
+                // то до конца диапазона и до следующего курсора ни один документ не попадёт в выдачу
+                double range_upper_bound = 0.0;
+                for (size_t i = 0; i < pivot_end; ++i) {
+                    range_upper_bound += active_terms[i]->cursor.GetRangeMaxTermFreq(pivot_slot)
+                        * active_terms[i]->inverse_document_freq;
+                }
+                if (range_upper_bound < threshold) {
+                    int64_t next_slot = pivot_end < active_terms.size()
+                        ? active_terms[pivot_end]->cursor.GetDocumentId()
+                        : INT64_MAX;
+                    for (size_t i = 0; i < pivot_end; ++i) {
+                        next_slot = std::min(next_slot, active_terms[i]->cursor.GetRangeEnd(pivot_slot));
+                    }
+                    for (size_t i = 0; i < pivot_end; ++i) {
+                        active_terms[i]->cursor.SkipTo(static_cast<int>(std::min<int64_t>(next_slot, INT_MAX)));
+                        ++postings_scanned;
+                    }
+                    continue;
+                }
+            }
+            if (active_terms.front()->cursor.GetDocumentId() != pivot_slot) {
+                // в документах раньше опорного есть только слова курсоров до него, а их оценок не хватает
+                for (size_t i = 0; i < pivot && active_terms[i]->cursor.GetDocumentId() < pivot_slot; ++i) {
+                    active_terms[i]->cursor.SkipTo(pivot_slot);
+                    ++postings_scanned;
+                }
                 continue;
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+
+            if (!PassesStatusFilter(document_predicate, pivot_slot)) {
+                // документ не подходит по статусу, и его вхождения даже не читаются
+            } else if (std::any_of(minus_cursors.begin(), minus_cursors.end(),
+                           [pivot_slot](PostingList::Cursor& minus_cursor) {
+                               return minus_cursor.SkipTo(pivot_slot);
+                           })) {
+                ++documents_excluded;
+            } else if (PassesPredicate(document_predicate, pivot_slot)) {
+                ++documents_scored;
+                double relevance = 0.0;
+                for (const TermCursor& term : terms) {
+                    if (is_active(term) && term.cursor.GetDocumentId() == pivot_slot) {
+                        relevance += term.cursor.GetTermFreq() * term.inverse_document_freq;
+                    }
+                }
+                const Document document{document_ids_[pivot_slot], relevance, document_ratings_[pivot_slot]};
+                if (heap.size() < top_count) {
+                    heap.push_back(document);
+                    std::push_heap(heap.begin(), heap.end(), RanksHigher);
+                } else if (RanksHigher(document, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), RanksHigher);
+                    heap.back() = document;
+                    std::push_heap(heap.begin(), heap.end(), RanksHigher);
+                }
+            }
+            for (size_t i = 0; i < active_terms.size() && active_terms[i]->cursor.GetDocumentId() == pivot_slot; ++i) {
+                active_terms[i]->cursor.Next();
+                ++postings_scanned;
             }
         }
+        STATS_COUNTER_ADD("postings_scanned"s, postings_scanned);
+        STATS_COUNTER_ADD("documents_scored"s, documents_scored);
+        STATS_COUNTER_ADD("documents_excluded"s, documents_excluded);
+
+        top_documents.insert(top_documents.end(), heap.begin(), heap.end());
+    }
+
+template <typename ShardScorer>
+    std::vector<Document> SearchServer::ScoreShards(const QueryPostings& postings, ShardScorer score_shard) const {
+        if (postings.plus_postings.empty()) {
+            return {};
+        }
+        // границы шардов берутся из самого длинного списка, чтобы шарды получались примерно равными
+        const PostingList* longest_postings = std::max_element(
+            postings.plus_postings.begin(), postings.plus_postings.end(),
+            [](const auto& lhs, const auto& rhs) {
+                return lhs.first->size() < rhs.first->size();
+            })->first;
+        const std::vector<int> shard_bounds = longest_postings->SampleDocumentIds(MIN_DOCUMENTS_PER_SHARD);
+
+        const size_t shard_count = shard_bounds.size() + 1;
+        std::vector<std::vector<Document>> shards(shard_count);
+        std::vector<size_t> shard_indexes(shard_count);
+        std::iota(shard_indexes.begin(), shard_indexes.end(), 0);
+        std::for_each(std::execution::par, shard_indexes.begin(), shard_indexes.end(),
+            [&](size_t shard_index) {
+                const bool is_first = shard_index == 0;
+                const bool is_last = shard_index + 1 == shard_count;
+                const int64_t lower = is_first ? INT64_MIN : shard_bounds[shard_index - 1];
+                const int64_t upper = is_last ? INT64_MAX : shard_bounds[shard_index];
+                score_shard(lower, upper, shards[shard_index]);
+            });
 
         std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back(
-                {document_id, relevance, documents_.at(document_id).rating});
+        for (const auto& shard_documents : shards) {
+            matched_documents.insert(matched_documents.end(), shard_documents.begin(), shard_documents.end());
         }
         return matched_documents;
+    }
+
+template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query,
+                                      DocumentPredicate document_predicate,
+                                      InverseDocumentFreq inverse_document_freq) const {
+        const QueryPostings postings = FindQueryPostings(query, inverse_document_freq);
+        return ScoreShards(postings, [&](int64_t lower, int64_t upper, std::vector<Document>& documents) {
+            ScoreDocuments(postings, lower, upper, document_predicate, documents);
+        });
+    }
+
+template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> SearchServer::FindTopCandidates(const std::execution::sequenced_policy&, const Query& query,
+                                      DocumentPredicate document_predicate, size_t top_count,
+                                      InverseDocumentFreq inverse_document_freq) const {
+        std::vector<Document> top_documents;
+        CollectTopDocuments(FindQueryPostings(query, inverse_document_freq), INT64_MIN, INT64_MAX,
+                            document_predicate, top_count, top_documents);
+        return top_documents;
+    }
+
+template <typename DocumentPredicate, typename InverseDocumentFreq>
+    std::vector<Document> SearchServer::FindTopCandidates(const std::execution::parallel_policy&, const Query& query,
+                                      DocumentPredicate document_predicate, size_t top_count,
+                                      InverseDocumentFreq inverse_document_freq) const {
+        // у каждого шарда свои лучшие, общие лучшие выберет SelectResultWindow
+        const QueryPostings postings = FindQueryPostings(query, inverse_document_freq);
+        return ScoreShards(postings, [&](int64_t lower, int64_t upper, std::vector<Document>& documents) {
+            CollectTopDocuments(postings, lower, upper, document_predicate, top_count, documents);
+        });
     }
\ No newline at end of file
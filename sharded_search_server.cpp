@@ -0,0 +1,81 @@
+#include <stdexcept>
+
+#include "sharded_search_server.h"
+#include "string_processing.h"
+
+    ShardedSearchServer::ShardedSearchServer(const std::string& stop_words_text, size_t shard_count)
+        : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count)
+    {
+    }
+
+    ShardedSearchServer::ShardedSearchServer(std::string_view stop_words_text, size_t shard_count)
+        : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count)
+    {
+    }
+
+    void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                          const std::vector<int>& ratings) {
+        if (document_id < 0) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+        Shard& shard = GetShard(document_id);
+        std::unique_lock lock(shard.mutex);
+        shard.server.AddDocument(document_id, document, status, ratings);
+    }
+
+    void ShardedSearchServer::RemoveDocument(int document_id) {
+        if (document_id < 0) {
+            return;
+        }
+        Shard& shard = GetShard(document_id);
+        std::unique_lock lock(shard.mutex);
+        shard.server.RemoveDocument(document_id);
+    }
+
+    std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                                                SearchOptions options) const {
+        return FindTopDocuments(raw_query, SearchServer::StatusFilter{status}, options);
+    }
+
+    std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query,
+                                                                SearchOptions options) const {
+        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL, options);
+    }
+
+    ShardedSearchServer::MatchedWords ShardedSearchServer::MatchDocument(std::string_view raw_query,
+                                                                         int document_id) const {
+        if (document_id < 0) {
+            throw std::out_of_range("Invalid document_id"s);
+        }
+        const Shard& shard = GetShard(document_id);
+        std::shared_lock lock(shard.mutex);
+        const auto [words, status] = shard.server.MatchDocument(raw_query, document_id);
+        return {std::vector<std::string>(words.begin(), words.end()), status};
+    }
+
+    int ShardedSearchServer::GetDocumentCount() const {
+        int document_count = 0;
+        for (const auto& shard : shards_) {
+            std::shared_lock lock(shard->mutex);
+            document_count += shard->server.GetDocumentCount();
+        }
+        return document_count;
+    }
+
+    size_t ShardedSearchServer::GetShardCount() const {
+        return shards_.size();
+    }
+
+    void ShardedSearchServer::CreateShards(const SearchServer& empty_server, size_t shard_count) {
+        if (shard_count == 0) {
+            throw std::invalid_argument("Shard count must be positive"s);
+        }
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>(empty_server));
+        }
+    }
+
+    ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) const {
+        return *shards_[static_cast<size_t>(document_id) % shards_.size()];
+    }
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cmath>
+#include <execution>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Поисковый сервер, документы которого разделены по id между shard_count независимыми
+// SearchServer. Запрос выполняется во всех шардах параллельно, и их лучшие документы сливаются.
+// IDF считается по числу документов и частотам слов во всех шардах, поэтому выдача совпадает
+// с выдачей одного SearchServer с теми же документами. Добавление и удаление блокируют
+// только шард документа и идут параллельно с изменениями других шардов
+class ShardedSearchServer {
+public:
+    template<typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count);
+
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count);
+
+    ShardedSearchServer(std::string_view stop_words_text, size_t shard_count);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                     const std::vector<int>& ratings);
+
+    // Удаление несуществующего документа ничего не делает
+    void RemoveDocument(int document_id);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                      DocumentPredicate document_predicate, SearchOptions options = {}) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                      SearchOptions options = {}) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, SearchOptions options = {}) const;
+
+    // Слова копируются, пока шард заблокирован: после снятия блокировки писатель может удалить
+    // слово из словаря шарда, и ссылки на него, как у SearchServer::MatchDocument, повисли бы
+    using MatchedWords = std::tuple<std::vector<std::string>, DocumentStatus>;
+
+    MatchedWords MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+private:
+    struct Shard {
+        explicit Shard(const SearchServer& empty_server)
+            : server(empty_server)
+        {
+        }
+
+        SearchServer server;
+        mutable std::shared_mutex mutex;
+    };
+
+    // мьютексы не перемещаются, поэтому шарды лежат по указателям
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    void CreateShards(const SearchServer& empty_server, size_t shard_count);
+
+    Shard& GetShard(int document_id) const;
+};
+
+template<typename StringContainer>
+    ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, size_t shard_count)
+    {
+        CreateShards(SearchServer(stop_words), shard_count);
+    }
+
+template <typename DocumentPredicate>
+    std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query,
+                                      DocumentPredicate document_predicate, SearchOptions options) const {
+        // шарды блокируются на чтение всегда в одном порядке, а писатель держит только один шард,
+        // поэтому взаимных блокировок нет, а статистика IDF согласована с индексами шардов
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            locks.emplace_back(shard->mutex);
+        }
+
+        // стоп-слова у всех шардов одни и те же
+        const auto query = shards_.front()->server.ParseQuery(raw_query);
+        int document_count = 0;
+        for (const auto& shard : shards_) {
+            document_count += shard->server.GetDocumentCount();
+        }
+        std::map<std::string_view, double> inverse_document_freqs;
+        for (const std::string_view word : query.plus_words) {
+            size_t document_freq = 0;
+            for (const auto& shard : shards_) {
+                const auto& word_to_document_freqs = shard->server.word_to_document_freqs_;
+                const auto it = word_to_document_freqs.find(word);
+                if (it != word_to_document_freqs.end()) {
+                    document_freq += it->second.postings.size();
+                }
+            }
+            if (document_freq > 0) {
+                inverse_document_freqs.emplace(word,
+                    SearchServer::ComputeInverseDocumentFreq(document_count, document_freq));
+            }
+        }
+        const auto global_inverse_document_freq = [&inverse_document_freqs](std::string_view word, const auto&) {
+            return inverse_document_freqs.at(word);
+        };
+
+        // окно [offset, offset + count) общей выдачи состоит из лучших документов шардов
+        SearchOptions shard_options = options;
+        shard_options.offset = 0;
+        shard_options.count = SearchServer::GetWindowEnd(options);
+        std::vector<std::vector<Document>> shard_results(shards_.size());
+        std::transform(std::execution::par, shards_.begin(), shards_.end(), shard_results.begin(),
+            [&](const std::unique_ptr<Shard>& shard) {
+                return shard->server.FindTopDocuments(std::execution::seq, query, document_predicate,
+                                                      shard_options, global_inverse_document_freq);
+            });
+
+        std::vector<Document> matched_documents;
+        for (const auto& shard_result : shard_results) {
+            matched_documents.insert(matched_documents.end(), shard_result.begin(), shard_result.end());
+        }
+        SearchServer::SelectResultWindow(std::execution::seq, matched_documents, options);
+        return matched_documents;
+    }
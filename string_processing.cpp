@@ -1,21 +1,214 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STRING_PROCESSING_X86
+#endif
+
 #include "string_processing.h"
 
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-    std::vector<std::string> words;
-    std::string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
+namespace {
+
+// Собирает слова по маскам пробелов и управляющих символов очередного куска текста
+class WordCollector {
+public:
+    WordCollector(std::string_view text, std::vector<std::string_view>& words)
+        : text_(text)
+        , words_(words)
+    {
+    }
+
+    // Бит i масок относится к символу base + i
+    void Consume(size_t base, uint64_t space_mask, uint64_t control_mask) {
+        if (control_mask != 0 && first_control_ == std::string_view::npos) {
+            first_control_ = base + __builtin_ctzll(control_mask);
+        }
+        while (space_mask != 0) {
+            const size_t space = base + __builtin_ctzll(space_mask);
+            if (space != word_begin_) {
+                words_.push_back(text_.substr(word_begin_, space - word_begin_));
+            }
+            word_begin_ = space + 1;
+            space_mask &= space_mask - 1;
+        }
+    }
+
+    // Дочитывает текст с from по одному символу и возвращает позицию первого управляющего символа
+    size_t Finish(size_t from) {
+        for (size_t i = from; i < text_.size(); ++i) {
+            const unsigned char c = text_[i];
+            if (c == ' ') {
+                if (i != word_begin_) {
+                    words_.push_back(text_.substr(word_begin_, i - word_begin_));
+                }
+                word_begin_ = i + 1;
+            } else if (c < ' ' && first_control_ == std::string_view::npos) {
+                first_control_ = i;
             }
-        } else {
-            word += c;
         }
+        if (word_begin_ < text_.size()) {
+            words_.push_back(text_.substr(word_begin_));
+        }
+        return first_control_;
+    }
+
+private:
+    std::string_view text_;
+    std::vector<std::string_view>& words_;
+    size_t word_begin_ = 0;
+    size_t first_control_ = std::string_view::npos;
+};
+
+using ScanFunction = size_t (*)(std::string_view, std::vector<std::string_view>&);
+
+size_t ScanScalar(std::string_view text, std::vector<std::string_view>& words) {
+    return WordCollector(text, words).Finish(0);
+}
+
+#ifdef STRING_PROCESSING_X86
+
+size_t ScanSse2(std::string_view text, std::vector<std::string_view>& words) {
+    WordCollector collector(text, words);
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i last_control = _mm_set1_epi8(' ' - 1);
+    size_t i = 0;
+    for (; i + 16 <= text.size(); i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        const uint32_t space_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces));
+        // беззнаковое c <= 31: min(c, 31) == c
+        const uint32_t control_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, last_control), chunk));
+        collector.Consume(i, space_mask, control_mask);
+    }
+    return collector.Finish(i);
+}
+
+__attribute__((target("avx2")))
+size_t ScanAvx2(std::string_view text, std::vector<std::string_view>& words) {
+    WordCollector collector(text, words);
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i last_control = _mm256_set1_epi8(' ' - 1);
+    size_t i = 0;
+    for (; i + 32 <= text.size(); i += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+        const uint32_t space_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, spaces));
+        const uint32_t control_mask = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, last_control), chunk));
+        collector.Consume(i, space_mask, control_mask);
+    }
+    return collector.Finish(i);
+}
+
+#endif
+
+struct Tokenizer {
+    ScanFunction scan;
+    std::string_view name;
+};
+
+const Tokenizer SCALAR_TOKENIZER{ScanScalar, "scalar"};
+#ifdef STRING_PROCESSING_X86
+const Tokenizer SSE2_TOKENIZER{ScanSse2, "sse2"};
+const Tokenizer AVX2_TOKENIZER{ScanAvx2, "avx2"};
+#endif
+
+const Tokenizer& GetDetectedTokenizer() {
+    static const Tokenizer& tokenizer = []() -> const Tokenizer& {
+#ifdef STRING_PROCESSING_X86
+        if (__builtin_cpu_supports("avx2")) {
+            return AVX2_TOKENIZER;
+        }
+        return SSE2_TOKENIZER;
+#else
+        return SCALAR_TOKENIZER;
+#endif
+    }();
+    return tokenizer;
+}
+
+// Реализация, выбранная SetTokenizerImplementation; nullptr - выбор по процессору
+std::atomic<const Tokenizer*> forced_tokenizer = nullptr;
+
+const Tokenizer& GetTokenizer() {
+    const Tokenizer* tokenizer = forced_tokenizer.load(std::memory_order_relaxed);
+    return tokenizer != nullptr ? *tokenizer : GetDetectedTokenizer();
+}
+
+CheckedWords SplitWith(ScanFunction scan, std::string_view text) {
+    CheckedWords result;
+    const size_t first_control = scan(text, result.words);
+    if (first_control != std::string_view::npos) {
+        // первое слово, которое кончается после управляющего символа, его и содержит
+        const auto word = std::partition_point(result.words.begin(), result.words.end(),
+            [&text, first_control](std::string_view word) {
+                return static_cast<size_t>(word.data() - text.data()) + word.size() <= first_control;
+            });
+        result.first_invalid_word = word - result.words.begin();
+    }
+    return result;
+}
+
+}  // namespace
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    return SplitIntoCheckedWords(text).words;
+}
+
+CheckedWords SplitIntoCheckedWords(std::string_view text) {
+    return SplitWith(GetTokenizer().scan, text);
+}
+
+CheckedWords SplitIntoCheckedWordsScalar(std::string_view text) {
+    return SplitWith(ScanScalar, text);
+}
+
+bool ContainsControlChars(std::string_view text) {
+    // слова короткие, поэтому векторный проход здесь не окупается
+    return std::any_of(text.begin(), text.end(), [](unsigned char c) {
+        return c < ' ';
+    });
+}
+
+std::string_view GetTokenizerImplementation() {
+    return GetTokenizer().name;
+}
+
+bool SetTokenizerImplementation(std::string_view name) {
+    using namespace std::string_literals;
+    if (name == "auto") {
+        forced_tokenizer = nullptr;
+        return true;
+    }
+    if (name == SCALAR_TOKENIZER.name) {
+        forced_tokenizer = &SCALAR_TOKENIZER;
+        return true;
+    }
+#ifdef STRING_PROCESSING_X86
+    if (name == SSE2_TOKENIZER.name) {
+        forced_tokenizer = &SSE2_TOKENIZER;
+        return true;
+    }
+    if (name == AVX2_TOKENIZER.name) {
+        if (!__builtin_cpu_supports("avx2")) {
+            return false;
+        }
+        forced_tokenizer = &AVX2_TOKENIZER;
+        return true;
     }
-    if (!word.empty()) {
-        words.push_back(word);
+#else
+    if (name == "sse2" || name == "avx2") {
+        return false;
     }
+#endif
+    throw std::invalid_argument("Unknown tokenizer implementation "s + std::string(name));
+}
 
-    return words;
-}
\ No newline at end of file
+uint64_t ComputeWordFingerprint(std::string_view word) {
+    // перемешивание из splitmix64, чтобы близкие хеши давали далёкие отпечатки
+    uint64_t hash = std::hash<std::string_view>{}(word);
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
@@ -1,18 +1,49 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <vector>
 #include <set>
 #include <string>
+#include <string_view>
 
-std::vector<std::string> SplitIntoWords(const std::string& text);
+// Возвращает слова text; они ссылаются на исходную строку и живут, пока жива она
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+
+// Слова текста и номер первого слова с управляющим символом (код от 0 до 31), если такое есть
+struct CheckedWords {
+    std::vector<std::string_view> words;
+    std::optional<size_t> first_invalid_word;
+};
+
+// Разбиение и поиск управляющих символов за один проход: пробелы и управляющие символы ищутся
+// сразу в 16 или 32 байтах (SSE2 или AVX2, выбор при первом вызове по возможностям процессора),
+// слова выдаются как string_view без копирования
+CheckedWords SplitIntoCheckedWords(std::string_view text);
+
+// То же без векторных инструкций
+CheckedWords SplitIntoCheckedWordsScalar(std::string_view text);
+
+bool ContainsControlChars(std::string_view text);
+
+// Название используемой реализации: "avx2", "sse2" или "scalar"
+std::string_view GetTokenizerImplementation();
+
+// Заставляет SplitIntoCheckedWords использовать реализацию name ("avx2", "sse2" или "scalar"),
+// "auto" возвращает выбор по процессору. Нужна тестам и замерам. Возвращает false и ничего не меняет,
+// если процессор реализацию не поддерживает; неизвестное имя - std::invalid_argument
+bool SetTokenizerImplementation(std::string_view name);
+
+// Отпечаток набора различных слов - сумма отпечатков слов, поэтому он не зависит от их порядка
+uint64_t ComputeWordFingerprint(std::string_view word);
 
 template<typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-    std::set<std::string> non_empty_strings;
-    for (const std::string& str : strings) {
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+    std::set<std::string, std::less<>> non_empty_strings;
+    for (const std::string_view str : strings) {
         if (!str.empty()) {
-            non_empty_strings.insert(str);
+            non_empty_strings.emplace(str);
         }
     }
     return non_empty_strings;
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "remove_duplicates.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+void CheckAddRejected(SearchServer& search_server, int document_id, const string& text) {
+    const int document_count = search_server.GetDocumentCount();
+    try {
+        search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1});
+        assert(false);
+    } catch (const invalid_argument&) {
+    }
+    assert(search_server.GetDocumentCount() == document_count);
+    assert(search_server.GetWordFrequencies(document_id).empty());
+}
+
+// Дубликат - документ с тем же набором слов без стоп-слов, независимо от порядка, повторов и частот
+void TestRejectDuplicates() {
+    SearchServer search_server("and with"s);
+    search_server.SetDuplicateMode(DuplicateMode::REJECT);
+    assert(search_server.GetDuplicateMode() == DuplicateMode::REJECT);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+
+    CheckAddRejected(search_server, 3, "rat nasty pet funny"s);
+    CheckAddRejected(search_server, 4, "funny funny pet and nasty rat rat with"s);
+    // подмножество и надмножество слов - не дубликаты
+    search_server.AddDocument(5, "funny pet nasty"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(6, "funny pet and nasty rat curly"s, DocumentStatus::ACTUAL, {1});
+    assert(search_server.GetDocumentCount() == 4);
+
+    assert(search_server.GetDocumentFingerprint(1) != search_server.GetDocumentFingerprint(5));
+    // после удаления оригинала его набор слов снова свободен
+    search_server.RemoveDocument(1);
+    search_server.AddDocument(3, "rat nasty pet funny"s, DocumentStatus::ACTUAL, {1});
+    CheckAddRejected(search_server, 7, "nasty funny rat pet"s);
+
+    // документы из одних стоп-слов совпадают по пустому набору слов
+    search_server.AddDocument(8, "and with"s, DocumentStatus::ACTUAL, {1});
+    CheckAddRejected(search_server, 9, "with"s);
+}
+
+// Включение REJECT у сервера с дубликатами их не удаляет, но новые дубликаты отвергаются
+void TestSwitchDuplicateMode() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat white"s, DocumentStatus::ACTUAL, {1});
+    assert(search_server.GetDocumentFingerprint(1) == search_server.GetDocumentFingerprint(2));
+
+    search_server.SetDuplicateMode(DuplicateMode::REJECT);
+    assert(search_server.GetDocumentCount() == 2);
+    CheckAddRejected(search_server, 3, "white and cat"s);
+    // удаление одного из двух одинаковых документов оставляет набор занятым
+    search_server.RemoveDocument(1);
+    CheckAddRejected(search_server, 3, "white and cat"s);
+
+    search_server.SetDuplicateMode(DuplicateMode::ALLOW);
+    search_server.AddDocument(3, "white and cat"s, DocumentStatus::ACTUAL, {1});
+    assert(search_server.GetDocumentCount() == 2);
+}
+
+// Пакетная загрузка ведёт себя как AddDocument по порядку: документы до дубликата остаются
+void TestRejectDuplicatesInBatch() {
+    for (const size_t batch_size : {size_t(1), size_t(2), size_t(100)}) {
+        SearchServer search_server("and"s);
+        search_server.SetDuplicateMode(DuplicateMode::REJECT);
+        search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+        vector<DocumentRecord> records = {
+            {2, "black dog"s, DocumentStatus::ACTUAL, {1}},
+            {3, "brown bird"s, DocumentStatus::ACTUAL, {1}},
+            // дубликат документа той же пачки
+            {4, "dog and black"s, DocumentStatus::ACTUAL, {1}},
+            {5, "grey mouse"s, DocumentStatus::ACTUAL, {1}},
+        };
+        BulkLoadOptions options;
+        options.batch_size = batch_size;
+        options.tokenizer_threads = 2;
+        try {
+            search_server.AddDocuments(records, options);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        assert(vector<int>(search_server.begin(), search_server.end()) == vector<int>({1, 2, 3}));
+
+        // дубликат уже добавленного документа
+        try {
+            search_server.AddDocuments({{6, "cat white"s, DocumentStatus::ACTUAL, {1}},
+                                        {7, "grey mouse"s, DocumentStatus::ACTUAL, {1}}}, options);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        assert(vector<int>(search_server.begin(), search_server.end()) == vector<int>({1, 2, 3}));
+        CheckAddRejected(search_server, 8, "bird brown"s);
+    }
+}
+
+// RemoveDuplicates seq и par оставляют документ с наименьшим id из каждой группы одинаковых
+void TestRemoveDuplicates() {
+    const vector<string> texts = {"a b c"s, "c b a"s, "a b"s, "b a a"s, "d"s, "a b c d"s, "c a b c"s, "and"s, ""s};
+    SearchServer removed_seq("and"s);
+    for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+        removed_seq.AddDocument(id + 10, texts[id], DocumentStatus::ACTUAL, {1});
+    }
+    SearchServer removed_par(removed_seq);
+    RemoveDuplicates(execution::seq, removed_seq);
+    RemoveDuplicates(execution::par, removed_par);
+    const vector<int> expected = {10, 12, 14, 15, 17};
+    assert(vector<int>(removed_seq.begin(), removed_seq.end()) == expected);
+    assert(vector<int>(removed_par.begin(), removed_par.end()) == expected);
+}
+
+}
+
+int main() {
+    TestRejectDuplicates();
+    TestSwitchDuplicateMode();
+    TestRejectDuplicatesInBatch();
+    TestRemoveDuplicates();
+    cout << "duplicate_detection_test OK"s << endl;
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+struct TestCorpus {
+    vector<string> texts;
+    vector<string> queries;
+};
+
+// Документов больше MIN_DOCUMENTS_PER_SHARD, чтобы параллельный подсчёт делил их на несколько шардов
+TestCorpus MakeTestCorpus(unsigned seed) {
+    mt19937 generator(seed);
+    const auto make_word = [&] {
+        const int rank = uniform_int_distribution(0, 49)(generator) * uniform_int_distribution(0, 49)(generator) / 49;
+        return "w"s + to_string(rank);
+    };
+    TestCorpus corpus;
+    for (size_t i = 0; i < 3 * MIN_DOCUMENTS_PER_SHARD; ++i) {
+        string text;
+        const int length = uniform_int_distribution(1, 12)(generator);
+        for (int j = 0; j < length; ++j) {
+            text += make_word() + " "s;
+        }
+        corpus.texts.push_back(move(text));
+    }
+    for (int i = 0; i < 200; ++i) {
+        string query;
+        const int length = uniform_int_distribution(1, 5)(generator);
+        for (int j = 0; j < length; ++j) {
+            query += (uniform_int_distribution(0, 4)(generator) == 0 ? "-"s : ""s) + make_word() + " "s;
+        }
+        corpus.queries.push_back(move(query));
+    }
+    return corpus;
+}
+
+SearchServer MakeSearchServer(const TestCorpus& corpus) {
+    SearchServer search_server("w0"s);
+    for (int id = 0; id < static_cast<int>(corpus.texts.size()); ++id) {
+        search_server.AddDocument(id, corpus.texts[id], static_cast<DocumentStatus>(id % 7 == 0 ? 1 : 0),
+                                  {id % 11 - 5});
+    }
+    return search_server;
+}
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(found[i].relevance == expected[i].relevance);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+void TestFindTopDocumentsSeqMatchesPar() {
+    const TestCorpus corpus = MakeTestCorpus(1);
+    const SearchServer search_server = MakeSearchServer(corpus);
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 0;
+    };
+    for (const string& query : corpus.queries) {
+        for (const auto [count, offset] : {pair{size_t(5), size_t(0)}, pair{size_t(20), size_t(7)}}) {
+            for (const auto algorithm : {TopDocumentsAlgorithm::EXHAUSTIVE, TopDocumentsAlgorithm::WAND}) {
+                const SearchOptions options{count, offset, algorithm};
+                const auto expected = search_server.FindTopDocuments(execution::seq, query, options);
+                CheckSameDocuments(search_server.FindTopDocuments(query, options), expected);
+                CheckSameDocuments(search_server.FindTopDocuments(execution::par, query, options), expected);
+                CheckSameDocuments(
+                    search_server.FindTopDocuments(execution::par, query, DocumentStatus::IRRELEVANT, options),
+                    search_server.FindTopDocuments(execution::seq, query, DocumentStatus::IRRELEVANT, options));
+                CheckSameDocuments(search_server.FindTopDocuments(execution::par, query, is_even, options),
+                                   search_server.FindTopDocuments(execution::seq, query, is_even, options));
+            }
+        }
+    }
+}
+
+// Удаление seq и par должно оставлять одинаковые индексы
+void TestRemoveDocumentSeqMatchesPar() {
+    const TestCorpus corpus = MakeTestCorpus(6);
+    SearchServer removed_seq = MakeSearchServer(corpus);
+    removed_seq.AddDocument(100000, "unique words only here"s, DocumentStatus::ACTUAL, {1});
+    SearchServer removed_par(removed_seq);
+    const int document_count = removed_seq.GetDocumentCount();
+
+    for (int id = 0; id < static_cast<int>(corpus.texts.size()); id += 3) {
+        removed_seq.RemoveDocument(execution::seq, id);
+        removed_par.RemoveDocument(execution::par, id);
+    }
+    removed_seq.RemoveDocument(100000);
+    removed_par.RemoveDocument(execution::par, 100000);
+    // удаление несуществующего документа ничего не делает
+    removed_seq.RemoveDocument(execution::seq, 100000);
+    removed_par.RemoveDocument(execution::par, -1);
+
+    const int removed_count = static_cast<int>((corpus.texts.size() + 2) / 3) + 1;
+    assert(removed_seq.GetDocumentCount() == document_count - removed_count);
+    assert(removed_par.GetDocumentCount() == removed_seq.GetDocumentCount());
+    assert(vector<int>(removed_par.begin(), removed_par.end()) == vector<int>(removed_seq.begin(), removed_seq.end()));
+    for (int id = 0; id < static_cast<int>(corpus.texts.size()); ++id) {
+        assert(removed_par.GetWordFrequencies(id) == removed_seq.GetWordFrequencies(id));
+        assert(id % 3 != 0 || removed_seq.GetWordFrequencies(id).empty());
+    }
+    // слова, которые были только в удалённом документе, пропадают из индекса
+    assert(removed_seq.FindTopDocuments("unique"s).empty());
+    assert(removed_par.FindTopDocuments("unique"s).empty());
+
+    for (const string& query : corpus.queries) {
+        const SearchOptions options{30, 0, TopDocumentsAlgorithm::EXHAUSTIVE};
+        CheckSameDocuments(removed_par.FindTopDocuments(execution::seq, query, options),
+                           removed_seq.FindTopDocuments(execution::seq, query, options));
+        CheckSameDocuments(removed_par.FindTopDocuments(execution::par, query, options),
+                           removed_seq.FindTopDocuments(execution::par, query, options));
+    }
+
+    // освободившиеся слоты занимают новые документы
+    removed_seq.AddDocument(0, "w1 w2"s, DocumentStatus::ACTUAL, {1});
+    removed_par.AddDocument(0, "w1 w2"s, DocumentStatus::ACTUAL, {1});
+    CheckSameDocuments(removed_par.FindTopDocuments(execution::par, "w1 w2"s),
+                       removed_seq.FindTopDocuments(execution::par, "w1 w2"s));
+}
+
+// MatchDocument seq и par находят одни и те же слова, и слова ссылаются на строки словаря сервера
+void TestMatchDocumentSeqMatchesPar() {
+    const TestCorpus corpus = MakeTestCorpus(7);
+    const SearchServer search_server = MakeSearchServer(corpus);
+    for (const string& query : corpus.queries) {
+        // повторы слов запроса не дают повторов в ответе
+        const string repeated_query = query + " "s + query;
+        for (int id = 0; id < static_cast<int>(corpus.texts.size()); id += 17) {
+            const auto [words, status] = search_server.MatchDocument(execution::seq, repeated_query, id);
+            const auto [par_words, par_status] = search_server.MatchDocument(execution::par, repeated_query, id);
+            assert(par_words == words);
+            assert(par_status == status);
+            assert(status == static_cast<DocumentStatus>(id % 7 == 0 ? 1 : 0));
+            assert(is_sorted(words.begin(), words.end()));
+            assert(adjacent_find(words.begin(), words.end()) == words.end());
+
+            const auto& word_freqs = search_server.GetWordFrequencies(id);
+            for (size_t i = 0; i < words.size(); ++i) {
+                const auto it = word_freqs.find(words[i]);
+                assert(it != word_freqs.end());
+                assert(words[i].data() == it->first.data() && par_words[i].data() == it->first.data());
+            }
+        }
+    }
+
+    const auto [words, status] = search_server.MatchDocument(execution::par, "w1 -w1"s, 1);
+    assert(words.empty());
+    try {
+        search_server.MatchDocument(execution::par, "w1"s, -1);
+        assert(false);
+    } catch (const out_of_range&) {
+    }
+    try {
+        search_server.MatchDocument(execution::seq, "w1 --w2"s, 1);
+        assert(false);
+    } catch (const invalid_argument&) {
+    }
+}
+
+}
+
+int main() {
+    TestFindTopDocumentsSeqMatchesPar();
+    TestRemoveDocumentSeqMatchesPar();
+    TestMatchDocumentSeqMatchesPar();
+    cout << "execution_policy_test OK"s << endl;
+}
@@ -0,0 +1,229 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string SNAPSHOT_PATH = (filesystem::temp_directory_path() / "index_snapshot_test.snap"s).string();
+
+// Смещение оглавления в заголовке снимка: после сигнатуры, версии и резерва
+const size_t INDEX_OFFSET_POSITION = 16;
+
+vector<string> MakeTexts(unsigned seed, size_t count) {
+    mt19937 generator(seed);
+    vector<string> texts;
+    for (size_t i = 0; i < count; ++i) {
+        string text;
+        const int length = uniform_int_distribution(1, 10)(generator);
+        for (int j = 0; j < length; ++j) {
+            const int rank = uniform_int_distribution(0, 29)(generator) * uniform_int_distribution(0, 29)(generator) / 29;
+            text += "w"s + to_string(rank) + " "s;
+        }
+        texts.push_back(move(text));
+    }
+    return texts;
+}
+
+// Сервер с позициями, несколькими статусами и удалёнными документами, чтобы в снимок попали свободные слоты
+SearchServer MakeSearchServer(const vector<string>& texts) {
+    SearchServer search_server("w0 and"s);
+    search_server.EnablePositionalIndex();
+    for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+        search_server.AddDocument(id * 2, texts[id], static_cast<DocumentStatus>(id % 5 == 0 ? 2 : 0), {id % 7, -3});
+    }
+    search_server.AddDocument(1000, "and"s, DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(1001, "only once here"s, DocumentStatus::ACTUAL, {});
+    for (int id = 0; id < static_cast<int>(texts.size()); id += 9) {
+        search_server.RemoveDocument(id * 2);
+    }
+    return search_server;
+}
+
+vector<string> MakeQueries() {
+    vector<string> queries = {"w1 w2 -w3"s, "+w4 w5"s, "\"w1 w2\""s, "\"w0 w3\" w7"s, "once here"s, "w1 -w1"s,
+                              "absent"s, "+absent w1"s};
+    for (int i = 1; i < 30; ++i) {
+        queries.push_back("w"s + to_string(i) + " w"s + to_string(30 - i));
+    }
+    return queries;
+}
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(found[i].relevance == expected[i].relevance);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+void CheckSameServers(const SearchServer& loaded, const SearchServer& expected) {
+    assert(loaded.GetDocumentCount() == expected.GetDocumentCount());
+    assert(vector<int>(loaded.begin(), loaded.end()) == vector<int>(expected.begin(), expected.end()));
+    for (const int document_id : expected) {
+        assert(loaded.GetWordFrequencies(document_id) == expected.GetWordFrequencies(document_id));
+    }
+    for (const string& query : MakeQueries()) {
+        for (const auto algorithm : {TopDocumentsAlgorithm::EXHAUSTIVE, TopDocumentsAlgorithm::WAND}) {
+            const SearchOptions options{20, 0, algorithm};
+            for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+                CheckSameDocuments(loaded.FindTopDocuments(query, status, options),
+                                   expected.FindTopDocuments(query, status, options));
+            }
+        }
+        for (const int document_id : expected) {
+            assert(loaded.MatchDocument(query, document_id) == expected.MatchDocument(query, document_id));
+        }
+    }
+}
+
+string ReadFile(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const string& data) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(data.data(), data.size());
+}
+
+uint64_t GetIndexOffset(const string& data) {
+    uint64_t index_offset;
+    memcpy(&index_offset, data.data() + INDEX_OFFSET_POSITION, sizeof(index_offset));
+    return index_offset;
+}
+
+void CheckLoadFails(const string& data) {
+    WriteFile(SNAPSHOT_PATH, data);
+    try {
+        SearchServer::LoadSnapshot(SNAPSHOT_PATH);
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+}
+
+void TestSnapshotRoundTrip() {
+    const auto texts = MakeTexts(8, 300);
+    const SearchServer search_server = MakeSearchServer(texts);
+    search_server.SaveSnapshot(SNAPSHOT_PATH);
+    const SearchServer loaded = SearchServer::LoadSnapshot(SNAPSHOT_PATH);
+    assert(loaded.HasPositionalIndex());
+    CheckSameServers(loaded, search_server);
+
+    // сжатые списки пишутся в снимок несжатыми, выдача та же
+    SearchServer compressed(search_server);
+    compressed.CompressPostings();
+    compressed.SaveSnapshot(SNAPSHOT_PATH);
+    CheckSameServers(SearchServer::LoadSnapshot(SNAPSHOT_PATH), search_server);
+
+    // копия держит отображение снимка и переживает загруженный сервер
+    optional<SearchServer> copy;
+    {
+        const SearchServer temporary = SearchServer::LoadSnapshot(SNAPSHOT_PATH);
+        copy.emplace(temporary);
+    }
+    CheckSameServers(*copy, search_server);
+}
+
+// Загруженный сервер меняется так же, как исходный: свободные слоты и слова снимка переживают загрузку
+void TestSnapshotMutationAfterLoad() {
+    const auto texts = MakeTexts(9, 200);
+    SearchServer search_server = MakeSearchServer(texts);
+    search_server.SaveSnapshot(SNAPSHOT_PATH);
+    SearchServer loaded = SearchServer::LoadSnapshot(SNAPSHOT_PATH);
+
+    for (SearchServer* server : {&search_server, &loaded}) {
+        server->AddDocument(5000, "w1 brand new words w1"s, DocumentStatus::ACTUAL, {4});
+        server->RemoveDocument(1001);
+        server->RemoveDocument(execution::par, 2);
+        server->AddDocument(5001, "once w2 w3"s, DocumentStatus::ACTUAL, {1});
+        server->CompressPostings();
+        server->RemoveDocument(5000);
+    }
+    assert(loaded.FindTopDocuments("brand"s).empty());
+    assert(loaded.FindTopDocuments("here"s).empty());
+    CheckSameServers(loaded, search_server);
+
+    // снимок изменённого загруженного сервера
+    loaded.SaveSnapshot(SNAPSHOT_PATH);
+    CheckSameServers(SearchServer::LoadSnapshot(SNAPSHOT_PATH), search_server);
+}
+
+void TestSnapshotCorruption() {
+    const auto texts = MakeTexts(10, 100);
+    const SearchServer search_server = MakeSearchServer(texts);
+    search_server.SaveSnapshot(SNAPSHOT_PATH);
+    const string data = ReadFile(SNAPSHOT_PATH);
+    const uint64_t index_offset = GetIndexOffset(data);
+    assert(index_offset < data.size());
+
+    // оборванный файл и испорченное оглавление отвергаются при загрузке
+    CheckLoadFails(data.substr(0, data.size() - 1));
+    CheckLoadFails(data.substr(0, index_offset));
+    CheckLoadFails(data.substr(0, 10));
+    string corrupted_index = data;
+    corrupted_index[index_offset + 5] ^= 1;
+    CheckLoadFails(corrupted_index);
+    CheckLoadFails("not a snapshot at all, just some text"s);
+
+    // первый блок данных сразу за заголовком - id документов первого слова словаря, "here"
+    string corrupted_block = data;
+    const size_t first_block = 40;
+    corrupted_block[first_block] ^= 1;
+    WriteFile(SNAPSHOT_PATH, corrupted_block);
+    SearchServer loaded = SearchServer::LoadSnapshot(SNAPSHOT_PATH);
+    // блок проверяется при первом обращении к слову; остальные слова работают
+    CheckSameDocuments(loaded.FindTopDocuments("w5 w6"s), search_server.FindTopDocuments("w5 w6"s));
+    try {
+        loaded.FindTopDocuments("here"s);
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+    try {
+        loaded.FindTopDocuments(execution::par, "-here w1"s);
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+    // изменения, которые задели бы испорченный список, отвергаются до изменения индекса
+    const int document_count = loaded.GetDocumentCount();
+    try {
+        loaded.AddDocument(7000, "here w1"s, DocumentStatus::ACTUAL, {});
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+    try {
+        loaded.RemoveDocument(execution::par, 1001);
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+    try {
+        loaded.CompressPostings();
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+    assert(loaded.GetDocumentCount() == document_count);
+    CheckSameDocuments(loaded.FindTopDocuments("w5 w6"s), search_server.FindTopDocuments("w5 w6"s));
+}
+
+}
+
+int main() {
+    TestSnapshotRoundTrip();
+    TestSnapshotMutationAfterLoad();
+    TestSnapshotCorruption();
+    filesystem::remove(SNAPSHOT_PATH);
+    cout << "index_snapshot_test OK"s << endl;
+}
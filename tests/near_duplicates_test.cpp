@@ -0,0 +1,135 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "near_duplicates.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+double ComputeJaccard(const SearchServer& search_server, int lhs_id, int rhs_id) {
+    const auto& lhs = search_server.GetWordFrequencies(lhs_id);
+    const auto& rhs = search_server.GetWordFrequencies(rhs_id);
+    size_t common = 0;
+    for (const auto& [word, _] : lhs) {
+        common += rhs.count(word);
+    }
+    return static_cast<double>(common) / (lhs.size() + rhs.size() - common);
+}
+
+// Документы - искажённые копии нескольких образцов, так что сходство пар разбросано от 0 до 1
+SearchServer MakeSearchServer(unsigned seed) {
+    mt19937 generator(seed);
+    SearchServer search_server("and"s);
+    for (int id = 0; id < 400; ++id) {
+        const int pattern = id % 20;
+        const int mutated_words = uniform_int_distribution(0, 12)(generator);
+        string text;
+        for (int word = 0; word < 20; ++word) {
+            text += word < mutated_words
+                ? "x"s + to_string(uniform_int_distribution(0, 5000)(generator)) + " "s
+                : "p"s + to_string(pattern) + "_"s + to_string(word) + " "s;
+        }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+    }
+    return search_server;
+}
+
+void CheckPairsAreExact(const SearchServer& search_server, const vector<NearDuplicatePair>& pairs, double threshold) {
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const auto& [first_id, second_id, similarity] = pairs[i];
+        assert(first_id < second_id);
+        assert(similarity >= threshold);
+        assert(similarity == ComputeJaccard(search_server, first_id, second_id));
+        assert(i == 0 || make_pair(pairs[i - 1].first_id, pairs[i - 1].second_id) < make_pair(first_id, second_id));
+    }
+}
+
+// Полосы подбираются по порогу: пары заметно выше порога находятся все, пар ниже порога нет
+void TestThresholdRecall() {
+    const SearchServer search_server = MakeSearchServer(12);
+    for (const double threshold : {0.3, 0.5, 0.8}) {
+        const auto pairs = FindNearDuplicates(search_server, threshold);
+        CheckPairsAreExact(search_server, pairs, threshold);
+        set<pair<int, int>> found;
+        for (const auto& near_duplicate : pairs) {
+            found.insert({near_duplicate.first_id, near_duplicate.second_id});
+        }
+        for (int lhs = 0; lhs < search_server.GetDocumentCount(); ++lhs) {
+            for (int rhs = lhs + 1; rhs < search_server.GetDocumentCount(); ++rhs) {
+                if (ComputeJaccard(search_server, lhs, rhs) >= threshold + 0.1) {
+                    assert(found.count({lhs, rhs}) > 0);
+                }
+            }
+        }
+    }
+
+    // заданные явно полосы не подбираются: с одной полосой из 64 строк похожие, но разные документы не находятся
+    NearDuplicateOptions options;
+    options.bands = 1;
+    options.rows_per_band = 64;
+    for (const auto& near_duplicate : FindNearDuplicates(search_server, 0.3, options)) {
+        assert(near_duplicate.similarity > 0.9);
+    }
+}
+
+// Большая группа одинаковых документов проверяется целиком, а не только парами с первым документом
+void TestLargeBucket() {
+    SearchServer search_server("and"s);
+    const int group_size = 150;
+    for (int id = 0; id < group_size; ++id) {
+        search_server.AddDocument(id, "same words in every document"s, DocumentStatus::ACTUAL, {1});
+    }
+    search_server.AddDocument(group_size, "same words in every text"s, DocumentStatus::ACTUAL, {1});
+    const auto pairs = FindNearDuplicates(search_server, 0.6);
+    CheckPairsAreExact(search_server, pairs, 0.6);
+    assert(pairs.size() == static_cast<size_t>((group_size + 1) * group_size / 2));
+    assert(pairs.back().first_id == group_size - 1 && pairs.back().second_id == group_size);
+}
+
+void TestEmptyDocuments() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "and"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "with and"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, ""s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, "cat and"s, DocumentStatus::ACTUAL, {1});
+    const auto pairs = FindNearDuplicates(search_server, 1.0);
+    assert(pairs.size() == 1);
+    assert(pairs[0].first_id == 4 && pairs[0].second_id == 5 && pairs[0].similarity == 1.0);
+}
+
+void TestInvalidArguments() {
+    const SearchServer search_server("and"s);
+    for (const double threshold : {0.0, -0.5, 1.5}) {
+        try {
+            FindNearDuplicates(search_server, threshold);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+    }
+    NearDuplicateOptions options;
+    options.signature_size = 0;
+    try {
+        FindNearDuplicates(search_server, 0.5, options);
+        assert(false);
+    } catch (const invalid_argument&) {
+    }
+}
+
+}
+
+int main() {
+    TestThresholdRecall();
+    TestLargeBucket();
+    TestEmptyDocuments();
+    TestInvalidArguments();
+    cout << "near_duplicates_test OK"s << endl;
+}
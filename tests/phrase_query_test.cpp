@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "string_processing.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in the"s;
+
+// Тексты документов, по которым запросы проверяются перебором
+using Texts = map<int, string>;
+
+Texts MakeTexts() {
+    return {
+        {1, "white cat and fashionable collar"s},
+        {2, "fluffy cat fluffy tail"s},
+        {3, "white and cat"s},
+        {4, "cat white"s},
+        {5, "the white cat in the city"s},
+        {6, "white in cat and white cat"s},
+        {7, "groomed dog expressive eyes"s},
+    };
+}
+
+SearchServer MakeSearchServer(const Texts& texts, bool positional_index = true) {
+    SearchServer search_server(STOP_WORDS);
+    if (positional_index) {
+        search_server.EnablePositionalIndex();
+    }
+    for (const auto& [id, text] : texts) {
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+    }
+    return search_server;
+}
+
+bool IsStopWord(string_view word) {
+    const auto stop_words = SplitIntoWords(STOP_WORDS);
+    return find(stop_words.begin(), stop_words.end(), word) != stop_words.end();
+}
+
+// Разбор запроса перебором: фраза - слова со смещениями, стоп-слова лишь занимают позиции
+struct NaiveQuery {
+    set<string> plus_words;
+    set<string> minus_words;
+    set<string> required_words;
+    vector<vector<pair<string, size_t>>> phrases;
+};
+
+NaiveQuery ParseNaive(const string& raw_query) {
+    NaiveQuery query;
+    const auto words = SplitIntoWords(raw_query);
+    for (size_t i = 0; i < words.size(); ++i) {
+        string_view word = words[i];
+        if (word[0] == '"') {
+            vector<pair<string, size_t>> phrase;
+            size_t offset = 0;
+            word.remove_prefix(1);
+            while (true) {
+                const bool is_end = !word.empty() && word.back() == '"';
+                if (is_end) {
+                    word.remove_suffix(1);
+                }
+                if (!word.empty()) {
+                    if (!IsStopWord(word)) {
+                        phrase.push_back({string(word), offset});
+                        query.plus_words.insert(string(word));
+                        query.required_words.insert(string(word));
+                    }
+                    ++offset;
+                }
+                if (is_end) {
+                    break;
+                }
+                word = words[++i];
+            }
+            query.phrases.push_back(phrase);
+        } else if (IsStopWord(word.substr(word[0] == '-' || word[0] == '+' ? 1 : 0))) {
+            continue;
+        } else if (word[0] == '-') {
+            query.minus_words.insert(string(word.substr(1)));
+        } else if (word[0] == '+') {
+            query.required_words.insert(string(word.substr(1)));
+            query.plus_words.insert(string(word.substr(1)));
+        } else {
+            query.plus_words.insert(string(word));
+        }
+    }
+    return query;
+}
+
+bool ContainsPhraseNaive(const vector<string_view>& words, const vector<pair<string, size_t>>& phrase) {
+    if (phrase.empty()) {
+        return true;
+    }
+    for (size_t start = 0; start < words.size(); ++start) {
+        const bool matches = all_of(phrase.begin(), phrase.end(), [&](const auto& phrase_word) {
+            const size_t position = start + phrase_word.second - phrase.front().second;
+            return position < words.size() && words[position] == phrase_word.first;
+        });
+        if (matches) {
+            return true;
+        }
+    }
+    return false;
+}
+
+set<int> FindNaive(const Texts& texts, const string& raw_query) {
+    const NaiveQuery query = ParseNaive(raw_query);
+    set<int> found;
+    for (const auto& [id, text] : texts) {
+        const auto words = SplitIntoWords(text);
+        const set<string_view> word_set(words.begin(), words.end());
+        const auto contains = [&word_set](const string& word) {
+            return word_set.count(word) > 0;
+        };
+        if (any_of(query.plus_words.begin(), query.plus_words.end(), contains)
+                && none_of(query.minus_words.begin(), query.minus_words.end(), contains)
+                && all_of(query.required_words.begin(), query.required_words.end(), contains)
+                && all_of(query.phrases.begin(), query.phrases.end(), [&words](const auto& phrase) {
+                    return ContainsPhraseNaive(words, phrase);
+                })) {
+            found.insert(id);
+        }
+    }
+    return found;
+}
+
+set<int> GetIds(const vector<Document>& documents) {
+    set<int> ids;
+    for (const Document& document : documents) {
+        ids.insert(document.id);
+    }
+    return ids;
+}
+
+// Все найденные документы, а не только первые DEFAULT_RESULT_DOCUMENT_COUNT
+set<int> FindIds(const SearchServer& search_server, const string& raw_query) {
+    return GetIds(search_server.FindTopDocuments(raw_query, SearchOptions{100}));
+}
+
+// Все способы поиска и MatchDocument находят то же, что перебор
+void CheckQuery(const SearchServer& search_server, const Texts& texts, const string& raw_query) {
+    const set<int> expected = FindNaive(texts, raw_query);
+    for (const auto algorithm : {TopDocumentsAlgorithm::EXHAUSTIVE, TopDocumentsAlgorithm::WAND}) {
+        const SearchOptions options{texts.size() + 1, 0, algorithm};
+        assert(GetIds(search_server.FindTopDocuments(raw_query, DocumentStatus::ACTUAL, options)) == expected);
+        assert(GetIds(search_server.FindTopDocuments(execution::par, raw_query, DocumentStatus::ACTUAL, options))
+               == expected);
+    }
+    for (const auto& [id, _] : texts) {
+        const auto [words, status] = search_server.MatchDocument(raw_query, id);
+        const auto [par_words, par_status] = search_server.MatchDocument(execution::par, raw_query, id);
+        assert(words.empty() == (expected.count(id) == 0));
+        assert(words == par_words);
+    }
+}
+
+void TestRequiredWords() {
+    const Texts texts = MakeTexts();
+    const SearchServer search_server = MakeSearchServer(texts, false);
+    for (const string query : {"+cat dog"s, "+cat +white"s, "+white -collar cat"s, "+absent cat"s, "+cat +cat"s,
+                               "+cat -cat"s, "+tail fluffy"s, "dog +and"s, "+the"s}) {
+        CheckQuery(search_server, texts, query);
+    }
+    assert(FindIds(search_server, "+cat dog"s) == set<int>({1, 2, 3, 4, 5, 6}));
+    // обязательное стоп-слово ничего не требует
+    assert(FindIds(search_server, "dog +and"s) == set<int>({7}));
+    for (const string query : {"+"s, "++cat"s, "+-cat"s, "-+cat"s}) {
+        try {
+            search_server.FindTopDocuments(query);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+    }
+}
+
+void TestPhrases() {
+    const Texts texts = MakeTexts();
+    const SearchServer search_server = MakeSearchServer(texts);
+    for (const string query : {"\"white cat\""s, "\"cat white\""s, "\"white and cat\""s, "\"white in cat\""s,
+                               "\"and white cat\""s, "\"the white cat\""s, "\"white cat\" -collar"s,
+                               "\"white cat\" \"cat and\""s, "dog \"fluffy tail\""s, "\"white  cat \""s,
+                               "\" white cat\""s, "\"cat\""s, "\"and the\" dog"s, "\"fluffy cat fluffy\""s,
+                               "\"cat -collar\""s}) {
+        CheckQuery(search_server, texts, query);
+    }
+    assert(FindIds(search_server, "\"white cat\""s) == set<int>({1, 5, 6}));
+    // стоп-слово внутри фразы занимает позицию: подходит любое слово на его месте, но не пропуск
+    assert(FindIds(search_server, "\"white and cat\""s) == set<int>({3, 6}));
+    // стоп-слова в начале фразы ничего не ограничивают
+    assert(FindIds(search_server, "\"the white cat\""s) == set<int>({1, 5, 6}));
+    // фраза из одних стоп-слов ничего не требует
+    assert(FindIds(search_server, "\"and the\" dog"s) == set<int>({7}));
+    // минус внутри фразы - часть слова, а не минус-слово
+    assert(search_server.FindTopDocuments("\"cat -collar\""s).empty());
+
+    // слова несовпавшей фразы MatchDocument не возвращает, хотя они в документе есть
+    const auto [words, status] = search_server.MatchDocument("\"cat white\" fluffy"s, 1);
+    assert(words.empty() && status == DocumentStatus::ACTUAL);
+    const auto [matched_words, _] = search_server.MatchDocument("\"cat white\" fluffy"s, 4);
+    assert(matched_words == vector<string_view>({"cat"sv, "white"sv}));
+}
+
+void TestInvalidPhrases() {
+    const Texts texts = MakeTexts();
+    const SearchServer search_server = MakeSearchServer(texts);
+    for (const string query : {"\""s, "cat \""s, "\"white cat"s, "\"white cat dog"s, "\"\""s, "\" \""s,
+                               "\"white c\x01t\""s}) {
+        try {
+            search_server.FindTopDocuments(query);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        try {
+            search_server.MatchDocument(query, 1);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+    }
+
+    // без позиционного индекса фраза из нескольких слов отвергается, а из одного - это обязательное слово
+    const SearchServer without_positions = MakeSearchServer(texts, false);
+    assert(!without_positions.HasPositionalIndex());
+    try {
+        without_positions.FindTopDocuments("\"white cat\""s);
+        assert(false);
+    } catch (const invalid_argument&) {
+    }
+    try {
+        without_positions.MatchDocument("\"the white cat\""s, 1);
+        assert(false);
+    } catch (const invalid_argument&) {
+    }
+    CheckQuery(without_positions, texts, "\"cat\" dog"s);
+    CheckQuery(without_positions, texts, "\"the cat\" dog"s);
+    // включить позиции можно только у пустого сервера
+    SearchServer copy = without_positions;
+    try {
+        copy.EnablePositionalIndex();
+        assert(false);
+    } catch (const logic_error&) {
+    }
+}
+
+// Фразы и обязательные слова остаются верными после удалений и сжатия списков
+void TestPhrasesAfterMutation() {
+    Texts texts = MakeTexts();
+    SearchServer search_server = MakeSearchServer(texts);
+    const vector<string> queries = {"\"white cat\""s, "\"white and cat\""s, "+white cat"s, "\"cat white\" +cat"s,
+                                    "\"fluffy tail\" dog"s, "+cat \"the white cat\" -city"s};
+
+    search_server.RemoveDocument(5);
+    texts.erase(5);
+    search_server.RemoveDocument(execution::par, 3);
+    texts.erase(3);
+    for (const string& query : queries) {
+        CheckQuery(search_server, texts, query);
+    }
+
+    search_server.CompressPostings();
+    for (const string& query : queries) {
+        CheckQuery(search_server, texts, query);
+    }
+
+    // слоты удалённых документов переиспользуются, и позиции нового документа не смешиваются со старыми
+    search_server.AddDocument(8, "cat and white"s, DocumentStatus::ACTUAL, {1});
+    texts[8] = "cat and white"s;
+    search_server.RemoveDocument(1);
+    texts.erase(1);
+    for (const string& query : queries) {
+        CheckQuery(search_server, texts, query);
+    }
+    assert(FindIds(search_server, "\"white cat\""s) == set<int>({6}));
+}
+
+// Случайные запросы на случайных документах совпадают с перебором
+void TestRandomQueries() {
+    mt19937 generator(24);
+    const vector<string> vocabulary = {"a"s, "b"s, "c"s, "d"s, "and"s, "the"s};
+    const auto random_word = [&] {
+        return vocabulary[uniform_int_distribution<size_t>(0, vocabulary.size() - 1)(generator)];
+    };
+    Texts texts;
+    for (int id = 0; id < 60; ++id) {
+        string text;
+        for (int i = uniform_int_distribution(1, 8)(generator); i > 0; --i) {
+            text += random_word() + " "s;
+        }
+        texts[id] = text;
+    }
+    const SearchServer search_server = MakeSearchServer(texts);
+    for (int iteration = 0; iteration < 300; ++iteration) {
+        string query;
+        for (int part = uniform_int_distribution(1, 3)(generator); part > 0; --part) {
+            switch (uniform_int_distribution(0, 3)(generator)) {
+                case 0: {
+                    query += "\""s;
+                    for (int i = uniform_int_distribution(1, 3)(generator); i > 0; --i) {
+                        query += random_word() + (i > 1 ? " "s : ""s);
+                    }
+                    query += "\" "s;
+                    break;
+                }
+                case 1:
+                    query += "+"s + random_word() + " "s;
+                    break;
+                case 2:
+                    query += "-"s + random_word() + " "s;
+                    break;
+                default:
+                    query += random_word() + " "s;
+            }
+        }
+        CheckQuery(search_server, texts, query);
+    }
+}
+
+}
+
+int main() {
+    TestRequiredWords();
+    TestPhrases();
+    TestInvalidPhrases();
+    TestPhrasesAfterMutation();
+    TestRandomQueries();
+    cout << "phrase_query_test OK"s << endl;
+}
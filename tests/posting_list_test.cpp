@@ -0,0 +1,183 @@
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "posting_list.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+// Список из size документов с id 3 * i, чтобы между соседними id были пропуски
+PostingList MakePostingList(size_t size) {
+    vector<int> document_ids;
+    vector<double> term_freqs;
+    for (size_t i = 0; i < size; ++i) {
+        document_ids.push_back(static_cast<int>(3 * i));
+        term_freqs.push_back(static_cast<double>(i % 5 + 1) / 7);
+    }
+    return PostingList(move(document_ids), move(term_freqs));
+}
+
+// Сверяет курсор с эталонными массивами: SkipTo из нового курсора к каждой цели
+// и SkipTo одним курсором по возрастающим целям вокруг границ блоков
+void CheckCursor(const PostingList& postings, const vector<int>& document_ids, const vector<double>& term_freqs) {
+    const int max_target = document_ids.empty() ? 1 : document_ids.back() + 2;
+    for (int target = -1; target <= max_target; ++target) {
+        PostingList::Cursor cursor(postings);
+        const bool found = cursor.SkipTo(target);
+        const auto expected = lower_bound(document_ids.begin(), document_ids.end(), target);
+        if (expected == document_ids.end()) {
+            assert(cursor.AtEnd() && !found);
+            continue;
+        }
+        assert(!cursor.AtEnd());
+        assert(cursor.GetDocumentId() == *expected);
+        assert(cursor.GetTermFreq() == term_freqs[expected - document_ids.begin()]);
+        assert(found == (*expected == target));
+    }
+
+    PostingList::Cursor cursor(postings);
+    size_t position = 0;
+    for (size_t boundary = PostingList::BLOCK_SIZE; boundary <= document_ids.size() + 1;
+         boundary += PostingList::BLOCK_SIZE) {
+        for (const size_t index : {boundary - 1, boundary, boundary + 1}) {
+            if (index >= document_ids.size()) {
+                continue;
+            }
+            // цель между документами index - 1 и index: курсор должен встать на index
+            const int target = document_ids[index] - 1;
+            assert(!cursor.SkipTo(target));
+            position = index;
+            assert(cursor.GetDocumentId() == document_ids[position]);
+            // повторный переход к текущему документу не сдвигает курсор
+            assert(cursor.SkipTo(document_ids[position]));
+            assert(cursor.GetDocumentId() == document_ids[position]);
+        }
+    }
+    // остаток списка обходится через Next с места, где остановился курсор
+    for (; position < document_ids.size(); ++position) {
+        assert(!cursor.AtEnd() && cursor.GetDocumentId() == document_ids[position]);
+        cursor.Next();
+    }
+    assert(cursor.AtEnd());
+    assert(!cursor.SkipTo(max_target));
+}
+
+void TestCursorSkipToAcrossBlockBoundaries() {
+    const size_t block_size = PostingList::BLOCK_SIZE;
+    for (const size_t size : {size_t(1), block_size - 1, block_size, block_size + 1,
+                              2 * block_size - 1, 2 * block_size, 2 * block_size + 1, 5 * block_size + 3}) {
+        PostingList postings = MakePostingList(size);
+        const auto document_ids = postings.GetDocumentIds();
+        const auto term_freqs = postings.GetTermFreqs();
+        CheckCursor(postings, document_ids, term_freqs);
+
+        postings.Compress();
+        assert(postings.IsCompressed());
+        assert(postings.size() == size);
+        assert(postings.GetDocumentIds() == document_ids);
+        assert(postings.GetTermFreqs() == term_freqs);
+        CheckCursor(postings, document_ids, term_freqs);
+
+        // удаление распаковывает список, а повторное сжатие должно дать тот же курсор
+        auto remaining_ids = document_ids;
+        auto remaining_freqs = term_freqs;
+        const size_t removed = min(size - 1, block_size);
+        assert(postings.Remove(document_ids[removed]));
+        assert(!postings.IsCompressed());
+        remaining_ids.erase(remaining_ids.begin() + removed);
+        remaining_freqs.erase(remaining_freqs.begin() + removed);
+        postings.Compress();
+        CheckCursor(postings, remaining_ids, remaining_freqs);
+    }
+}
+
+struct TestCorpus {
+    vector<string> texts;
+    vector<string> queries;
+};
+
+// Частые слова попадают в тысячи документов, так что их списки занимают много блоков
+TestCorpus MakeTestCorpus() {
+    mt19937 generator(18);
+    const auto make_word = [&] {
+        const int rank = uniform_int_distribution(0, 59)(generator) * uniform_int_distribution(0, 59)(generator) / 59;
+        return "w"s + to_string(rank);
+    };
+    TestCorpus corpus;
+    for (int i = 0; i < 3000; ++i) {
+        string text;
+        const int length = uniform_int_distribution(1, 20)(generator);
+        for (int j = 0; j < length; ++j) {
+            text += make_word() + " "s;
+        }
+        corpus.texts.push_back(move(text));
+    }
+    for (int i = 0; i < 300; ++i) {
+        string query;
+        const int length = uniform_int_distribution(1, 5)(generator);
+        for (int j = 0; j < length; ++j) {
+            query += (uniform_int_distribution(0, 4)(generator) == 0 ? "-"s : ""s) + make_word() + " "s;
+        }
+        corpus.queries.push_back(move(query));
+    }
+    return corpus;
+}
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(found[i].relevance == expected[i].relevance);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+// Сжатие не должно менять ни состав, ни порядок, ни релевантность результатов
+// при той же политике выполнения
+void CheckSameResults(const SearchServer& plain, const SearchServer& compressed, const vector<string>& queries) {
+    for (const string& query : queries) {
+        for (const size_t count : {size_t(5), size_t(10000)}) {
+            SearchOptions options;
+            options.count = count;
+            CheckSameDocuments(compressed.FindTopDocuments(execution::seq, query, options),
+                               plain.FindTopDocuments(execution::seq, query, options));
+            CheckSameDocuments(compressed.FindTopDocuments(execution::par, query, options),
+                               plain.FindTopDocuments(execution::par, query, options));
+        }
+    }
+}
+
+void TestCompressedPostingsGiveSameResults() {
+    const TestCorpus corpus = MakeTestCorpus();
+    SearchServer plain("w0"s);
+    for (int id = 0; id < static_cast<int>(corpus.texts.size()); ++id) {
+        plain.AddDocument(id, corpus.texts[id], DocumentStatus::ACTUAL, {id % 7 - 3});
+    }
+    SearchServer compressed(plain);
+    compressed.CompressPostings();
+    assert(compressed.GetPostingsMemoryUsage() < plain.GetPostingsMemoryUsage());
+    CheckSameResults(plain, compressed, corpus.queries);
+
+    // удаление из сжатых списков, затем повторное сжатие
+    for (int id = 0; id < static_cast<int>(corpus.texts.size()); id += 7) {
+        plain.RemoveDocument(id);
+        compressed.RemoveDocument(id);
+    }
+    CheckSameResults(plain, compressed, corpus.queries);
+    compressed.CompressPostings();
+    CheckSameResults(plain, compressed, corpus.queries);
+}
+
+}
+
+int main() {
+    TestCursorSkipToAcrossBlockBoundaries();
+    TestCompressedPostingsGiveSameResults();
+    cout << "posting_list_test OK"s << endl;
+}
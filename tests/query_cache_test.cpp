@@ -0,0 +1,133 @@
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+SearchServer MakeSearchServer() {
+    SearchServer search_server("and in"s);
+    search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, {8, -3});
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+    search_server.AddDocument(4, "groomed starling evgeny"s, DocumentStatus::BANNED, {9});
+    search_server.AddDocument(5, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    return search_server;
+}
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(found[i].relevance == expected[i].relevance);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+void CheckStats(const SearchServer& search_server, size_t hits, size_t misses) {
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    assert(stats.hits == hits);
+    assert(stats.misses == misses);
+}
+
+// Ключ - разобранный запрос: порядок, повторы и стоп-слова не дробят кеш, а статус, окно и алгоритм - дробят
+void TestQueryCacheHits() {
+    SearchServer search_server = MakeSearchServer();
+    const SearchServer uncached = MakeSearchServer();
+    search_server.EnableQueryCache(1 << 20);
+    CheckStats(search_server, 0, 0);
+
+    const auto expected = uncached.FindTopDocuments("fluffy groomed cat -collar"s);
+    CheckSameDocuments(search_server.FindTopDocuments("fluffy groomed cat -collar"s), expected);
+    CheckStats(search_server, 0, 1);
+    CheckSameDocuments(search_server.FindTopDocuments("cat -collar groomed and fluffy cat"s), expected);
+    CheckSameDocuments(search_server.FindTopDocuments(execution::par, "groomed fluffy cat -collar"s), expected);
+    CheckStats(search_server, 2, 1);
+
+    search_server.FindTopDocuments("fluffy groomed cat -collar"s, DocumentStatus::BANNED);
+    search_server.FindTopDocuments("fluffy groomed cat -collar"s, SearchOptions{2, 0});
+    search_server.FindTopDocuments("fluffy groomed cat -collar"s, SearchOptions{5, 1});
+    const SearchOptions wand{DEFAULT_RESULT_DOCUMENT_COUNT, 0, TopDocumentsAlgorithm::WAND};
+    CheckSameDocuments(search_server.FindTopDocuments("fluffy groomed cat -collar"s, wand), expected);
+    // минус-слово - не плюс-слово
+    search_server.FindTopDocuments("fluffy groomed cat collar"s);
+    CheckStats(search_server, 2, 6);
+    CheckSameDocuments(search_server.FindTopDocuments("fluffy groomed cat -collar"s, wand), expected);
+    CheckStats(search_server, 3, 6);
+    assert(search_server.GetQueryCacheStats().entries == 6);
+
+    // запросы с предикатом мимо кеша
+    search_server.FindTopDocuments("cat"s, [](int, DocumentStatus, int) { return true; });
+    CheckStats(search_server, 3, 6);
+
+    // копия получает свой пустой кеш того же размера
+    const SearchServer copy(search_server);
+    CheckStats(copy, 0, 0);
+    assert(copy.GetQueryCacheStats().memory_budget == 1 << 20);
+
+    search_server.DisableQueryCache();
+    CheckStats(search_server, 0, 0);
+    CheckSameDocuments(search_server.FindTopDocuments("fluffy groomed cat -collar"s), expected);
+}
+
+// Изменение индекса меняет эпоху, и выдачи прежней эпохи больше не возвращаются
+void TestQueryCacheInvalidation() {
+    SearchServer search_server = MakeSearchServer();
+    search_server.EnableQueryCache(1 << 20);
+    const auto before = search_server.FindTopDocuments("cat"s);
+    assert(before.size() == 3);
+    search_server.FindTopDocuments("cat"s);
+    CheckStats(search_server, 1, 1);
+
+    search_server.AddDocument(6, "cat cat cat"s, DocumentStatus::ACTUAL, {1});
+    const auto after_add = search_server.FindTopDocuments("cat"s);
+    CheckStats(search_server, 1, 2);
+    assert(search_server.GetQueryCacheStats().invalidations == 1);
+    assert(after_add.size() == 4 && after_add[0].id == 6);
+
+    search_server.RemoveDocument(6);
+    CheckSameDocuments(search_server.FindTopDocuments("cat"s), before);
+    CheckStats(search_server, 1, 3);
+    assert(search_server.GetQueryCacheStats().invalidations == 2);
+
+    // пакетная загрузка - тоже изменение индекса
+    search_server.AddDocuments({{7, "cat"s, DocumentStatus::ACTUAL, {1}}});
+    assert(search_server.FindTopDocuments("cat"s).size() == 4);
+    CheckStats(search_server, 1, 4);
+
+    // удаление несуществующего документа индекс не меняет
+    search_server.RemoveDocument(100);
+    search_server.FindTopDocuments("cat"s);
+    CheckStats(search_server, 2, 4);
+}
+
+void TestQueryCacheEviction() {
+    SearchServer search_server = MakeSearchServer();
+    search_server.EnableQueryCache(1000);
+    const vector<string> queries = {"cat"s, "dog"s, "fluffy"s, "groomed"s, "collar"s, "tail"s, "eyes"s, "city"s};
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(query);
+    }
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    assert(stats.evictions > 0);
+    assert(stats.memory_usage <= stats.memory_budget);
+    assert(stats.entries + stats.evictions == queries.size());
+    // последний запрос ещё в кеше, первый вытеснен
+    search_server.FindTopDocuments(queries.back());
+    search_server.FindTopDocuments(queries.front());
+    CheckStats(search_server, 1, queries.size() + 1);
+}
+
+}
+
+int main() {
+    TestQueryCacheHits();
+    TestQueryCacheInvalidation();
+    TestQueryCacheEviction();
+    cout << "query_cache_test OK"s << endl;
+}
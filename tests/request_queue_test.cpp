@@ -0,0 +1,137 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "request_queue.h"
+#include "search_server.h"
+
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+SearchServer MakeSearchServer() {
+    SearchServer search_server("and in"s);
+    search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, {8, -3});
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(3, "groomed starling evgeny"s, DocumentStatus::BANNED, {9});
+    return search_server;
+}
+
+// Часы, которые двигает тест
+struct ManualClock {
+    RequestQueue::Clock::time_point now = RequestQueue::Clock::now();
+
+    RequestQueue::TimeSource GetTimeSource() {
+        return [this] {
+            return now;
+        };
+    }
+};
+
+void CheckCounts(const RequestQueue& request_queue, StatisticsWindow window, uint64_t requests,
+                 uint64_t no_result_requests) {
+    const RequestStatistics statistics = request_queue.GetStatistics(window);
+    assert(statistics.requests == requests);
+    assert(statistics.no_result_requests == no_result_requests);
+    if (requests > 0) {
+        assert(statistics.no_result_rate == static_cast<double>(no_result_requests) / requests);
+        assert(statistics.p50_ns > 0);
+        assert(statistics.p50_ns <= statistics.p99_ns && statistics.p99_ns <= statistics.p999_ns);
+    }
+}
+
+void TestStatistics() {
+    const SearchServer search_server = MakeSearchServer();
+    ManualClock clock;
+    RequestQueue request_queue(search_server, clock.GetTimeSource());
+    for (const auto window : {StatisticsWindow::MINUTE, StatisticsWindow::HOUR, StatisticsWindow::DAY}) {
+        const RequestStatistics statistics = request_queue.GetStatistics(window);
+        assert(statistics.requests == 0 && statistics.p50_ns == 0 && statistics.requests_per_second == 0.0);
+    }
+
+    clock.now += 10s;
+    assert(request_queue.AddFindRequest("cat"s).size() == 2);
+    assert(request_queue.AddFindRequest("dog"s).empty());
+    // статус передаётся как есть, и запрос с результатом среди забаненных не считается пустым
+    assert(request_queue.AddFindRequest("starling"s, DocumentStatus::BANNED).size() == 1);
+    assert(request_queue.AddFindRequest("cat"s, [](int, DocumentStatus, int rating) {
+        return rating > 100;
+    }).empty());
+    CheckCounts(request_queue, StatisticsWindow::MINUTE, 4, 2);
+    CheckCounts(request_queue, StatisticsWindow::DAY, 4, 2);
+    // окно ещё не заполнено, и частота считается по прошедшим 10 секундам
+    assert(request_queue.GetStatistics(StatisticsWindow::MINUTE).requests_per_second == 0.4);
+    assert(request_queue.GetNoResultRequests() == 2);
+}
+
+// Запросы уходят из минутного, часового и суточного окон по очереди
+void TestDayWindow() {
+    const SearchServer search_server = MakeSearchServer();
+    ManualClock clock;
+    RequestQueue request_queue(search_server, clock.GetTimeSource());
+    for (int i = 0; i < 3; ++i) {
+        request_queue.AddFindRequest("dog"s);
+    }
+    request_queue.AddFindRequest("cat"s);
+
+    clock.now += 2min;
+    CheckCounts(request_queue, StatisticsWindow::MINUTE, 0, 0);
+    assert(request_queue.GetStatistics(StatisticsWindow::MINUTE).p50_ns == 0);
+    CheckCounts(request_queue, StatisticsWindow::HOUR, 4, 3);
+    request_queue.AddFindRequest("dog"s);
+    CheckCounts(request_queue, StatisticsWindow::MINUTE, 1, 1);
+
+    clock.now += 2h;
+    CheckCounts(request_queue, StatisticsWindow::HOUR, 0, 0);
+    CheckCounts(request_queue, StatisticsWindow::DAY, 5, 4);
+    assert(request_queue.GetNoResultRequests() == 4);
+    request_queue.AddFindRequest("cat"s);
+
+    // через сутки после первых запросов их часовая корзина выходит из окна, а запрос третьего часа ещё нет
+    clock.now += 22h - 2min - 30s;
+    CheckCounts(request_queue, StatisticsWindow::DAY, 6, 4);
+    clock.now += 1min;
+    CheckCounts(request_queue, StatisticsWindow::DAY, 1, 0);
+    assert(request_queue.GetNoResultRequests() == 0);
+
+    // корзины старых суток переиспользуются и считаются заново
+    clock.now += 24h;
+    CheckCounts(request_queue, StatisticsWindow::DAY, 0, 0);
+    request_queue.AddFindRequest("dog"s);
+    CheckCounts(request_queue, StatisticsWindow::DAY, 1, 1);
+    assert(request_queue.GetNoResultRequests() == 1);
+}
+
+// Запросы из разных потоков пишутся в разные полосы, а статистика сливает их все
+void TestConcurrentRequests() {
+    const SearchServer search_server = MakeSearchServer();
+    RequestQueue request_queue(search_server);
+    const int thread_count = 6;
+    const int requests_per_thread = 500;
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < requests_per_thread; ++i) {
+                request_queue.AddFindRequest(i % 5 == 0 ? "dog"s : "cat"s);
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    CheckCounts(request_queue, StatisticsWindow::DAY, thread_count * requests_per_thread,
+                thread_count * requests_per_thread / 5);
+}
+
+}
+
+int main() {
+    TestStatistics();
+    TestDayWindow();
+    TestConcurrentRequests();
+    cout << "request_queue_test OK"s << endl;
+}
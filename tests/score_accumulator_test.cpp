@@ -0,0 +1,84 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "score_accumulator.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+size_t GetThreadCapacity(size_t slot_count) {
+    const auto accumulator = ScoreAccumulator::Acquire(slot_count);
+    return accumulator->GetSlotCapacity();
+}
+
+void AccumulateAll(size_t slot_count) {
+    const auto accumulator = ScoreAccumulator::Acquire(slot_count);
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        accumulator->Add(static_cast<int>(slot), 1.0, [](int) {
+            return true;
+        });
+    }
+}
+
+// Накопитель потока растёт под большой сервер и ужимается, только когда запросы долго идут к маленьким
+void TestShrinkAfterSmallLeases() {
+    const size_t large = ScoreAccumulator::MIN_SHRINK_SLOTS * 8;
+    const size_t small = 1000;
+    AccumulateAll(large);
+    assert(GetThreadCapacity(small) == large);
+
+    // чередование с большим сервером сбрасывает счёт маленьких аренд
+    for (int i = 0; i < ScoreAccumulator::SHRINK_AFTER_LEASES * 2; ++i) {
+        AccumulateAll(i % 10 == 0 ? large : small);
+    }
+    assert(GetThreadCapacity(large) == large);
+
+    // сервер меньше всего в 2 раза не ужимает накопитель
+    for (int i = 0; i < ScoreAccumulator::SHRINK_AFTER_LEASES * 2; ++i) {
+        AccumulateAll(large / 2);
+    }
+    assert(GetThreadCapacity(large) == large);
+
+    for (int i = 0; i < ScoreAccumulator::SHRINK_AFTER_LEASES; ++i) {
+        AccumulateAll(small);
+    }
+    assert(GetThreadCapacity(small) == small);
+    // после ужатия накопитель пуст и снова растёт
+    AccumulateAll(large);
+    assert(GetThreadCapacity(small) == large);
+}
+
+// Ужатие не портит выдачу: после запросов к маленькому серверу большой находит то же
+void TestSearchAfterShrink() {
+    SearchServer large_server("and"s);
+    for (int id = 0; id < static_cast<int>(ScoreAccumulator::MIN_SHRINK_SLOTS) + 1000; ++id) {
+        large_server.AddDocument(id, id % 3 == 0 ? "white cat"s : "black dog"s, DocumentStatus::ACTUAL, {id % 11});
+    }
+    SearchServer small_server("and"s);
+    small_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, {1});
+    small_server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, {2});
+
+    const vector<Document> expected = large_server.FindTopDocuments("white cat"s);
+    for (int i = 0; i < ScoreAccumulator::SHRINK_AFTER_LEASES; ++i) {
+        const vector<Document> found = small_server.FindTopDocuments("cat -dog"s);
+        assert(found.size() == 1 && found[0].id == 1);
+    }
+    assert(GetThreadCapacity(2) < ScoreAccumulator::MIN_SHRINK_SLOTS);
+    const vector<Document> found = large_server.FindTopDocuments("white cat"s);
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance);
+    }
+}
+
+}
+
+int main() {
+    TestShrinkAfterSmallLeases();
+    TestSearchAfterShrink();
+    cout << "score_accumulator_test OK"s << endl;
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "search_server.h"
+#include "sharded_search_server.h"
+
+using namespace std;
+
+namespace {
+
+string MakeText(int document_id) {
+    return "w"s + to_string(document_id % 13) + " w"s + to_string(document_id % 7) + " and w"s
+        + to_string(document_id % 3);
+}
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(abs(found[i].relevance - expected[i].relevance) < RELEVANCE_EPSILON);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+// IDF считается по всем шардам, поэтому выдача и совпавшие слова те же, что у одного сервера
+void TestShardedMatchesSingleServer() {
+    SearchServer search_server("and"s);
+    ShardedSearchServer sharded_server("and"s, 3);
+    for (int id = 0; id < 200; ++id) {
+        const auto status = static_cast<DocumentStatus>(id % 9 == 0 ? 1 : 0);
+        search_server.AddDocument(id, MakeText(id), status, {id % 10});
+        sharded_server.AddDocument(id, MakeText(id), status, {id % 10});
+    }
+    for (int id = 0; id < 200; id += 11) {
+        search_server.RemoveDocument(id);
+        sharded_server.RemoveDocument(id);
+    }
+    assert(sharded_server.GetDocumentCount() == search_server.GetDocumentCount());
+
+    for (const string& query : {"w1 w2 -w4"s, "w5 w12"s, "w0 and w6"s, "+w3 w1"s, "absent"s}) {
+        const SearchOptions window{7, 3};
+        CheckSameDocuments(sharded_server.FindTopDocuments(query, window), search_server.FindTopDocuments(query, window));
+        CheckSameDocuments(sharded_server.FindTopDocuments(query, DocumentStatus::IRRELEVANT),
+                           search_server.FindTopDocuments(query, DocumentStatus::IRRELEVANT));
+        for (int id = 1; id < 200; id += 5) {
+            if (id % 11 == 0) {
+                continue;
+            }
+            const auto [words, status] = sharded_server.MatchDocument(query, id);
+            const auto [expected_words, expected_status] = search_server.MatchDocument(query, id);
+            assert(vector<string>(expected_words.begin(), expected_words.end()) == words);
+            assert(status == expected_status);
+        }
+    }
+}
+
+// Писатель удаляет документ вместе с его словами из словаря шарда и добавляет снова.
+// Слова, которые вернул MatchDocument, принадлежат вызывающему и остаются целы после снятия блокировки
+void TestConcurrentMatchDocument() {
+    ShardedSearchServer sharded_server("and"s, 2);
+    const int document_id = 2;
+    const string text = "volatile words here"s;
+    sharded_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1});
+    sharded_server.AddDocument(4, "stable words"s, DocumentStatus::ACTUAL, {1});
+
+    atomic<bool> writer_done = false;
+    thread writer([&] {
+        for (int i = 0; i < 2000; ++i) {
+            sharded_server.RemoveDocument(document_id);
+            sharded_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {1});
+        }
+        writer_done = true;
+    });
+
+    size_t matches = 0;
+    vector<vector<string>> results;
+    while (!writer_done || matches == 0) {
+        try {
+            auto [words, status] = sharded_server.MatchDocument("volatile here -absent"s, document_id);
+            assert(status == DocumentStatus::ACTUAL);
+            results.push_back(move(words));
+            ++matches;
+        } catch (const out_of_range&) {
+            // документ удалён между проверками писателя
+        }
+        const auto [stable_words, _] = sharded_server.MatchDocument("stable words"s, 4);
+        assert(stable_words == vector<string>({"stable"s, "words"s}));
+    }
+    writer.join();
+    for (const auto& words : results) {
+        assert(words == vector<string>({"here"s, "volatile"s}));
+    }
+}
+
+}
+
+int main() {
+    TestShardedMatchesSingleServer();
+    TestConcurrentMatchDocument();
+    cout << "sharded_search_server_test OK"s << endl;
+}
@@ -0,0 +1,107 @@
+#include <cassert>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const vector<DocumentStatus> STATUSES = {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED,
+                                         DocumentStatus::REMOVED};
+
+// Статусы перемешаны, часть документов удалена, чтобы фильтр встречал и свободные слоты
+SearchServer MakeSearchServer(unsigned seed) {
+    mt19937 generator(seed);
+    SearchServer search_server("and the"s);
+    search_server.EnablePositionalIndex();
+    for (int id = 0; id < 500; ++id) {
+        string text;
+        for (int i = uniform_int_distribution(1, 12)(generator); i > 0; --i) {
+            const int rank = uniform_int_distribution(0, 30)(generator) * uniform_int_distribution(0, 30)(generator) / 30;
+            text += rank == 0 ? "and "s : "w"s + to_string(rank) + " "s;
+        }
+        const DocumentStatus status = STATUSES[uniform_int_distribution<size_t>(0, STATUSES.size() - 1)(generator)];
+        search_server.AddDocument(id * 3, text, status, {uniform_int_distribution(-10, 10)(generator)});
+    }
+    for (int id = 0; id < 500; id += 7) {
+        search_server.RemoveDocument(id * 3);
+    }
+    return search_server;
+}
+
+vector<string> MakeQueries() {
+    vector<string> queries = {"w1 w2 -w3"s, "+w4 w5"s, "\"w1 w2\""s, "w1 -w1"s, "absent"s, "+absent w1"s,
+                              "\"and w3\" w7"s, "-w2 w2 w3 w4 w5 w6"s};
+    for (int i = 1; i < 30; i += 2) {
+        queries.push_back("w"s + to_string(i) + " w"s + to_string(30 - i) + " w"s + to_string(i + 1));
+    }
+    return queries;
+}
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(found[i].relevance == expected[i].relevance);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+// Поиск по статусу идёт быстрым путём StatusFilter и должен совпадать с тем же условием в предикате
+void CheckStatusFilter(const SearchServer& search_server) {
+    for (const string& query : MakeQueries()) {
+        for (const auto algorithm : {TopDocumentsAlgorithm::EXHAUSTIVE, TopDocumentsAlgorithm::WAND}) {
+            for (const SearchOptions options : {SearchOptions{5, 0, algorithm}, SearchOptions{1000, 0, algorithm},
+                                                SearchOptions{4, 3, algorithm}}) {
+                for (const DocumentStatus status : STATUSES) {
+                    const auto by_predicate = [status](int, DocumentStatus document_status, int) {
+                        return document_status == status;
+                    };
+                    CheckSameDocuments(search_server.FindTopDocuments(query, status, options),
+                                       search_server.FindTopDocuments(query, by_predicate, options));
+                    CheckSameDocuments(search_server.FindTopDocuments(execution::par, query, status, options),
+                                       search_server.FindTopDocuments(execution::par, query, by_predicate, options));
+                }
+            }
+        }
+    }
+}
+
+void TestStatusFilterMatchesPredicate() {
+    SearchServer search_server = MakeSearchServer(25);
+    CheckStatusFilter(search_server);
+    search_server.CompressPostings();
+    CheckStatusFilter(search_server);
+    // выдача из кеша та же, что у предиката, который кеш обходит
+    search_server.EnableQueryCache(1 << 20);
+    CheckStatusFilter(search_server);
+    CheckStatusFilter(search_server);
+}
+
+// Предикат с другим условием не идёт быстрым путём и проверяется целиком
+void TestPredicateStillApplied() {
+    const SearchServer search_server = MakeSearchServer(26);
+    const SearchOptions options{1000};
+    for (const string& query : MakeQueries()) {
+        for (const Document& document : search_server.FindTopDocuments(query, [](int document_id, DocumentStatus status,
+                                                                                 int rating) {
+                 return document_id % 2 == 0 && status != DocumentStatus::BANNED && rating > 0;
+             }, options)) {
+            assert(document.id % 2 == 0 && document.rating > 0);
+            assert(get<1>(search_server.MatchDocument(query, document.id)) != DocumentStatus::BANNED);
+        }
+    }
+}
+
+}
+
+int main() {
+    TestStatusFilterMatchesPredicate();
+    TestPredicateStillApplied();
+    cout << "status_filter_test OK"s << endl;
+}
@@ -0,0 +1,130 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_processing.h"
+
+using namespace std;
+
+namespace {
+
+const vector<string> IMPLEMENTATIONS = {"scalar"s, "sse2"s, "avx2"s};
+
+// Очевидное разбиение по одному символу, с которым сравнивается скалярная реализация
+CheckedWords SplitNaive(string_view text) {
+    CheckedWords result;
+    size_t word_begin = 0;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        if (i == text.size() || text[i] == ' ') {
+            if (i != word_begin) {
+                const string_view word = text.substr(word_begin, i - word_begin);
+                if (!result.first_invalid_word && ContainsControlChars(word)) {
+                    result.first_invalid_word = result.words.size();
+                }
+                result.words.push_back(word);
+            }
+            word_begin = i + 1;
+        }
+    }
+    return result;
+}
+
+// Слова сравниваются и по содержимому, и по положению в тексте
+void CheckSameWords(const CheckedWords& checked, const CheckedWords& expected) {
+    assert(checked.first_invalid_word == expected.first_invalid_word);
+    assert(checked.words.size() == expected.words.size());
+    for (size_t i = 0; i < checked.words.size(); ++i) {
+        assert(checked.words[i].data() == expected.words[i].data());
+        assert(checked.words[i].size() == expected.words[i].size());
+    }
+}
+
+void CheckAllImplementations(string_view text) {
+    const CheckedWords expected = SplitNaive(text);
+    CheckSameWords(SplitIntoCheckedWordsScalar(text), expected);
+    for (const string& implementation : IMPLEMENTATIONS) {
+        if (SetTokenizerImplementation(implementation)) {
+            assert(GetTokenizerImplementation() == implementation);
+            CheckSameWords(SplitIntoCheckedWords(text), expected);
+        }
+    }
+    SetTokenizerImplementation("auto"s);
+}
+
+// Байты, на которых векторное сравнение легче всего ошибиться: границы управляющих символов,
+// пробел и соседние с ним, байты от 0x80 (отрицательные как знаковые)
+const string TRICKY_BYTES = "\x00\x01\x09\x0a\x1f\x20\x21\x7f\x80\x9f\xa0\xdf\xff"
+                            "ab"s;
+
+void TestAdversarialBytes() {
+    // каждый байт в каждой позиции векторного блока и в хвосте
+    for (const char byte : TRICKY_BYTES) {
+        for (size_t length = 1; length <= 70; ++length) {
+            for (size_t position = 0; position < length; ++position) {
+                string text(length, 'x');
+                text[position] = byte;
+                CheckAllImplementations(text);
+                text.assign(length, ' ');
+                text[position] = byte;
+                CheckAllImplementations(text);
+            }
+        }
+    }
+
+    mt19937 generator(19);
+    for (int iteration = 0; iteration < 3000; ++iteration) {
+        const size_t length = uniform_int_distribution<size_t>(0, 150)(generator);
+        string text;
+        for (size_t i = 0; i < length; ++i) {
+            text += TRICKY_BYTES[uniform_int_distribution<size_t>(0, TRICKY_BYTES.size() - 1)(generator)];
+        }
+        CheckAllImplementations(text);
+    }
+}
+
+// Представления, начатые и законченные внутри буфера: невыровненные загрузки и хвосты
+void TestMisalignedViews() {
+    mt19937 generator(20);
+    string buffer;
+    for (int i = 0; i < 300; ++i) {
+        buffer += uniform_int_distribution(0, 3)(generator) == 0 ? ' ' : static_cast<char>('a' + i % 26);
+    }
+    buffer[150] = '\x05';
+    buffer[151] = '\xf0';
+    const string_view view = buffer;
+    for (size_t offset = 0; offset < 40; ++offset) {
+        for (size_t length = 0; offset + length <= view.size(); length += 7) {
+            CheckAllImplementations(view.substr(offset, length));
+        }
+    }
+    // управляющий символ сразу за концом представления в него не попадает
+    CheckAllImplementations(view.substr(100, 50));
+    assert(!SplitIntoCheckedWords(view.substr(100, 50)).first_invalid_word);
+}
+
+void TestImplementationSelection() {
+    const string detected(GetTokenizerImplementation());
+    assert(SetTokenizerImplementation("scalar"s));
+    assert(GetTokenizerImplementation() == "scalar"s);
+    try {
+        SetTokenizerImplementation("neon"s);
+        assert(false);
+    } catch (const invalid_argument&) {
+    }
+    assert(GetTokenizerImplementation() == "scalar"s);
+    assert(SetTokenizerImplementation("auto"s));
+    assert(GetTokenizerImplementation() == detected);
+}
+
+}
+
+int main() {
+    TestAdversarialBytes();
+    TestMisalignedViews();
+    TestImplementationSelection();
+    cout << "string_processing_test OK"s << endl;
+}
@@ -0,0 +1,134 @@
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "versioned_search_server.h"
+
+using namespace std;
+
+namespace {
+
+// В каждой версии все документы содержат слово common, поэтому поиск по нему возвращает
+// их все, а MatchDocument каждого находит это слово
+const string COMMON_QUERY = "common"s;
+const int INITIAL_DOCUMENT_COUNT = 100;
+
+string MakeText(int document_id) {
+    return "common w"s + to_string(document_id % 17) + " w"s + to_string(document_id % 5);
+}
+
+// Проверяет, что снимок внутренне согласован: число документов, итерация по id,
+// результаты поиска и MatchDocument описывают одно и то же множество документов
+set<int> CheckSnapshot(const SearchServer& snapshot) {
+    const set<int> document_ids(snapshot.begin(), snapshot.end());
+    assert(static_cast<size_t>(snapshot.GetDocumentCount()) == document_ids.size());
+
+    SearchOptions options;
+    options.count = document_ids.size() + 1;
+    const auto documents = snapshot.FindTopDocuments(COMMON_QUERY, options);
+    set<int> found_ids;
+    for (const Document& document : documents) {
+        found_ids.insert(document.id);
+    }
+    assert(found_ids.size() == documents.size());
+    assert(found_ids == document_ids);
+
+    for (const int document_id : document_ids) {
+        const auto [words, status] = snapshot.MatchDocument(COMMON_QUERY, document_id);
+        assert(words.size() == 1 && words[0] == COMMON_QUERY);
+        assert(status == DocumentStatus::ACTUAL);
+    }
+    return document_ids;
+}
+
+void TestReadersSeeConsistentSnapshotsDuringPublish() {
+    SearchServer search_server("and with"s);
+    for (int id = 0; id < INITIAL_DOCUMENT_COUNT; ++id) {
+        search_server.AddDocument(id, MakeText(id), DocumentStatus::ACTUAL, {id % 10});
+    }
+    VersionedSearchServer versioned_server(std::move(search_server));
+
+    atomic<bool> writer_done = false;
+    atomic<size_t> checked_snapshots = 0;
+    const auto read = [&] {
+        while (!writer_done) {
+            {
+                const auto snapshot = versioned_server.GetSnapshot();
+                const uint64_t version = versioned_server.GetVersion();
+                const set<int> document_ids = CheckSnapshot(*snapshot);
+                // писатель публикует только целые шаги: добавил 10 документов и удалил 10 самых старых,
+                // поэтому в любой версии ровно INITIAL_DOCUMENT_COUNT идущих подряд id
+                assert(document_ids.size() == static_cast<size_t>(INITIAL_DOCUMENT_COUNT));
+                assert(*document_ids.rbegin() - *document_ids.begin() == INITIAL_DOCUMENT_COUNT - 1);
+                // пока ссылка жива, снимок не меняется, сколько бы версий ни вышло после него
+                this_thread::yield();
+                assert(CheckSnapshot(*snapshot) == document_ids);
+                assert(versioned_server.GetVersion() >= version);
+            }
+            // счётчик нужен только для чередования потоков и не должен сам упорядочивать чтения
+            // с записями писателя, иначе он скрыл бы отсутствие синхронизации в VersionedSearchServer
+            checked_snapshots.fetch_add(1, memory_order_relaxed);
+            // снимок отпущен: писатель может как раз сейчас сделать эту версию резервной и начать её менять
+            this_thread::yield();
+        }
+    };
+
+    vector<thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back(read);
+    }
+
+    const int step_count = 1000;
+    const int step_size = 10;
+    for (int step = 0; step < step_count; ++step) {
+        const int first_new_id = INITIAL_DOCUMENT_COUNT + step * step_size;
+        for (int i = 0; i < step_size; ++i) {
+            const int document_id = first_new_id + i;
+            versioned_server.AddDocument(document_id, MakeText(document_id), DocumentStatus::ACTUAL, {1});
+            versioned_server.RemoveDocument(first_new_id - INITIAL_DOCUMENT_COUNT + i);
+        }
+        versioned_server.Publish();
+        if (step % 10 == 0) {
+            // ждём, пока читатели проверят ещё хотя бы один снимок, чтобы публикации шли вперемешку
+            // с чтением, в том числе пока прежнюю версию держит читатель
+            const size_t checked_before = checked_snapshots.load(memory_order_relaxed);
+            while (checked_snapshots.load(memory_order_relaxed) == checked_before) {
+                this_thread::yield();
+            }
+        }
+    }
+    writer_done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    assert(versioned_server.GetVersion() == static_cast<uint64_t>(step_count));
+    const set<int> final_ids = CheckSnapshot(*versioned_server.GetSnapshot());
+    assert(*final_ids.begin() == step_count * step_size);
+    assert(*final_ids.rbegin() == INITIAL_DOCUMENT_COUNT + step_count * step_size - 1);
+}
+
+void TestSnapshotOutlivesServer() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, MakeText(1), DocumentStatus::ACTUAL, {1});
+    shared_ptr<const SearchServer> snapshot;
+    {
+        VersionedSearchServer versioned_server(std::move(search_server));
+        versioned_server.AddDocument(2, MakeText(2), DocumentStatus::ACTUAL, {1});
+        versioned_server.Publish();
+        snapshot = versioned_server.GetSnapshot();
+    }
+    assert(CheckSnapshot(*snapshot) == (set<int>{1, 2}));
+}
+
+}
+
+int main() {
+    TestReadersSeeConsistentSnapshotsDuringPublish();
+    TestSnapshotOutlivesServer();
+    cout << "versioned_search_server_test OK"s << endl;
+}
@@ -0,0 +1,146 @@
+#include <cassert>
+#include <cmath>
+#include <execution>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+void CheckSameDocuments(const vector<Document>& found, const vector<Document>& expected) {
+    assert(found.size() == expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        assert(found[i].id == expected[i].id);
+        assert(found[i].relevance == expected[i].relevance);
+        assert(found[i].rating == expected[i].rating);
+    }
+}
+
+// WAND обязан возвращать ровно то же, что полный перебор при той же политике выполнения
+void CheckWandMatchesExhaustive(const SearchServer& search_server, const string& query,
+                                const vector<size_t>& counts) {
+    for (const size_t count : counts) {
+        SearchOptions exhaustive;
+        exhaustive.count = count;
+        SearchOptions wand = exhaustive;
+        wand.algorithm = TopDocumentsAlgorithm::WAND;
+        CheckSameDocuments(search_server.FindTopDocuments(execution::seq, query, wand),
+                           search_server.FindTopDocuments(execution::seq, query, exhaustive));
+        CheckSameDocuments(search_server.FindTopDocuments(execution::par, query, wand),
+                           search_server.FindTopDocuments(execution::par, query, exhaustive));
+    }
+}
+
+// Группа документов со словом target: у документа длины base_length + length_offset релевантность
+// на length_offset * STEP меньше, чем у документа длины base_length
+struct TieGroup {
+    int length_offset;
+    int rating;
+    // ожидаемый отрыв от группы с нулевым смещением, в долях RELEVANCE_EPSILON
+    double min_gap;
+    double max_gap;
+};
+
+// Релевантности групп отстоят от худшего документа выдачи меньше чем на допуск равенства (тогда решает
+// рейтинг), между одним и двумя допусками (такие документы WAND обязан оценить, но в выдачу они не
+// попадают) и больше чем на два допуска (их WAND вправе пропустить, в том числе целым диапазоном)
+void TestWandMatchesExhaustiveOnNearTies() {
+    const vector<TieGroup> groups = {
+        {0, 1, 0.0, 0.0},
+        {1, 9, 0.2, 0.3},
+        {6, 9, 1.4, 1.6},
+        {7, 9, 1.6, 1.8},
+        {10, 9, 2.3, 2.6},
+        {40, 9, 9.0, 11.0},
+    };
+    const int group_size = 40;
+    const int filler_document_count = 3 * group_size * static_cast<int>(groups.size());
+    // слово target есть в четверти документов, его IDF = ln 4. Шаг длины на единицу меняет
+    // релевантность на ln 4 / (L * (L + 1)), это около четверти RELEVANCE_EPSILON
+    const double inverse_document_freq = log(4.0);
+    const int base_length = static_cast<int>(sqrt(inverse_document_freq / (0.25 * RELEVANCE_EPSILON)));
+
+    SearchServer search_server("and"s);
+    // группы идут сплошными отрезками id, так что у списка target есть диапазоны из одной группы
+    for (size_t group = 0; group < groups.size(); ++group) {
+        for (int i = 0; i < group_size; ++i) {
+            const int document_id = static_cast<int>(group) * 1000 + i;
+            string text = "target"s;
+            // у части документов с высоким рейтингом есть минус-слово, они ранжировались бы выше
+            const bool has_spam = i % 4 == 0;
+            const int filler_count = base_length + groups[group].length_offset - 1 - (has_spam ? 1 : 0);
+            for (int j = 0; j < filler_count; ++j) {
+                text += " filler"s;
+            }
+            if (has_spam) {
+                text += " spam"s;
+            }
+            search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {groups[group].rating});
+        }
+    }
+    for (int i = 0; i < filler_document_count; ++i) {
+        search_server.AddDocument(100000 + i, "other words only"s, DocumentStatus::ACTUAL, {5});
+    }
+
+    // проверяем, что отрывы групп такие, как задумано
+    SearchOptions all;
+    all.count = 100000;
+    map<int, double> relevances;
+    for (const Document& document : search_server.FindTopDocuments("target"s, all)) {
+        relevances[document.id] = document.relevance;
+    }
+    assert(relevances.size() == groups.size() * group_size);
+    const double top_relevance = relevances.at(0);
+    for (size_t group = 0; group < groups.size(); ++group) {
+        for (int i = 0; i < group_size; ++i) {
+            const double gap = (top_relevance - relevances.at(static_cast<int>(group) * 1000 + i)) / RELEVANCE_EPSILON;
+            assert(gap >= groups[group].min_gap && gap <= groups[group].max_gap);
+        }
+    }
+
+    // окна, граница которых приходится внутрь разных групп и на их стыки
+    const vector<size_t> counts = {1, 5, 20, 30, 40, 45, 60, 80, 100, 130, 200, 1000};
+    CheckWandMatchesExhaustive(search_server, "target"s, counts);
+    CheckWandMatchesExhaustive(search_server, "target -spam"s, counts);
+    CheckWandMatchesExhaustive(search_server, "target other -spam"s, counts);
+}
+
+void TestWandMatchesExhaustiveOnRandomCorpus() {
+    mt19937 generator(23);
+    const auto make_word = [&] {
+        const int rank = uniform_int_distribution(0, 79)(generator) * uniform_int_distribution(0, 79)(generator) / 79;
+        return "w"s + to_string(rank);
+    };
+    SearchServer search_server("w0"s);
+    for (int id = 0; id < 4000; ++id) {
+        string text;
+        const int length = uniform_int_distribution(1, 30)(generator);
+        for (int j = 0; j < length; ++j) {
+            text += make_word() + " "s;
+        }
+        search_server.AddDocument(id, text, static_cast<DocumentStatus>(id % 10 == 0 ? 1 : 0),
+                                  {uniform_int_distribution(-5, 5)(generator)});
+    }
+    for (int i = 0; i < 300; ++i) {
+        string query;
+        const int length = uniform_int_distribution(1, 6)(generator);
+        for (int j = 0; j < length; ++j) {
+            query += (uniform_int_distribution(0, 4)(generator) == 0 ? "-"s : ""s) + make_word() + " "s;
+        }
+        CheckWandMatchesExhaustive(search_server, query, {1, 5, 50});
+    }
+}
+
+}
+
+int main() {
+    TestWandMatchesExhaustiveOnNearTies();
+    TestWandMatchesExhaustiveOnRandomCorpus();
+    cout << "wand_test OK"s << endl;
+}
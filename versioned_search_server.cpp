@@ -0,0 +1,122 @@
+#include <set>
+
+#include "remove_duplicates.h"
+#include "versioned_search_server.h"
+
+    VersionedSearchServer::Mutation VersionedSearchServer::Mutation::Addition(
+            int document_id, std::string_view text, DocumentStatus status, const std::vector<int>& ratings) {
+        return {false, document_id, std::string(text), status, ratings};
+    }
+
+    VersionedSearchServer::Mutation VersionedSearchServer::Mutation::Removal(int document_id) {
+        return {true, document_id, {}, DocumentStatus::ACTUAL, {}};
+    }
+
+    void VersionedSearchServer::RecycleBin::Put(std::unique_ptr<SearchServer> released_server,
+                                                uint64_t released_version) {
+        std::lock_guard guard(mutex);
+        if (released_version == awaited_version) {
+            server = std::move(released_server);
+        } else {
+            garbage.push_back(std::move(released_server));
+        }
+    }
+
+    std::unique_ptr<SearchServer> VersionedSearchServer::RecycleBin::Take(uint64_t next_awaited_version,
+            std::vector<std::unique_ptr<SearchServer>>& released_garbage) {
+        std::lock_guard guard(mutex);
+        awaited_version = next_awaited_version;
+        released_garbage.swap(garbage);
+        return std::move(server);
+    }
+
+    VersionedSearchServer::VersionedSearchServer(SearchServer search_server)
+        // обе копии создаются изменяемыми: опубликованная версия потом станет резервной
+        : published_(Share(std::make_unique<SearchServer>(search_server), 0))
+        , standby_(std::make_unique<SearchServer>(std::move(search_server)))
+    {
+    }
+
+    std::shared_ptr<const SearchServer> VersionedSearchServer::Share(std::unique_ptr<SearchServer> server,
+                                                                     uint64_t version) const {
+        return std::shared_ptr<const SearchServer>(server.release(),
+            [recycle_bin = recycle_bin_, version](const SearchServer* released_server) {
+                recycle_bin->Put(std::unique_ptr<SearchServer>(const_cast<SearchServer*>(released_server)), version);
+            });
+    }
+
+    std::shared_ptr<const SearchServer> VersionedSearchServer::GetSnapshot() const {
+        return std::atomic_load(&published_);
+    }
+
+    std::vector<Document> VersionedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                                                  SearchOptions options) const {
+        return GetSnapshot()->FindTopDocuments(raw_query, status, options);
+    }
+
+    std::vector<Document> VersionedSearchServer::FindTopDocuments(std::string_view raw_query,
+                                                                  SearchOptions options) const {
+        return GetSnapshot()->FindTopDocuments(raw_query, options);
+    }
+
+    void VersionedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                            const std::vector<int>& ratings) {
+        std::lock_guard guard(writer_mutex_);
+        standby_->AddDocument(document_id, document, status, ratings);
+        pending_.push_back(Mutation::Addition(document_id, document, status, ratings));
+    }
+
+    void VersionedSearchServer::RemoveDocument(int document_id) {
+        std::lock_guard guard(writer_mutex_);
+        standby_->RemoveDocument(document_id);
+        pending_.push_back(Mutation::Removal(document_id));
+    }
+
+    void VersionedSearchServer::RemoveDuplicates() {
+        std::lock_guard guard(writer_mutex_);
+        const std::set<int> document_ids(standby_->begin(), standby_->end());
+        ::RemoveDuplicates(*standby_);
+        // в журнал попадают удаления, чтобы повтор на другой копии не печатал дубликаты ещё раз
+        auto remaining = standby_->begin();
+        for (const int document_id : document_ids) {
+            if (remaining != standby_->end() && *remaining == document_id) {
+                ++remaining;
+            } else {
+                pending_.push_back(Mutation::Removal(document_id));
+            }
+        }
+    }
+
+    void VersionedSearchServer::Publish() {
+        std::lock_guard guard(writer_mutex_);
+        if (pending_.empty()) {
+            return;
+        }
+        const uint64_t previous_version = version_;
+        std::atomic_store(&published_, Share(std::move(standby_), previous_version + 1));
+        ++version_;
+
+        // после замены указателя новые ссылки на прежнюю версию появиться не могут; если её уже
+        // отпустили все читатели, удалитель вернул её в корзину, и мьютекс корзины упорядочивает
+        // их последние чтения перед изменениями ниже
+        std::vector<std::unique_ptr<SearchServer>> garbage;
+        standby_ = recycle_bin_->Take(previous_version + 1, garbage);
+        // отпущенные читателями ненужные версии удаляются здесь, в потоке писателя, и без мьютекса корзины
+        garbage.clear();
+        if (standby_) {
+            for (const Mutation& mutation : pending_) {
+                if (mutation.is_removal) {
+                    standby_->RemoveDocument(mutation.document_id);
+                } else {
+                    standby_->AddDocument(mutation.document_id, mutation.text, mutation.status, mutation.ratings);
+                }
+            }
+        } else {
+            standby_ = std::make_unique<SearchServer>(*std::atomic_load(&published_));
+        }
+        pending_.clear();
+    }
+
+    uint64_t VersionedSearchServer::GetVersion() const {
+        return version_.load();
+    }
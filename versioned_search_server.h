@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Поисковый сервер, читатели которого не блокируются писателем. Читатель берёт неизменяемую
+// опубликованную версию индекса и работает с ней без блокировок, сколько бы изменений ни шло.
+// Писатель меняет вторую, резервную копию и публикует её атомарной заменой указателя.
+// Старая версия, когда её отпустят все читатели, становится резервной и догоняет новую
+// повтором журнала изменений, так что публикация стоит O(числа изменений), а не O(размера индекса).
+// Если старую версию ещё держит читатель, резервная копия создаётся копированием новой.
+// Версию возвращает писателю удалитель shared_ptr: он срабатывает только после того, как все
+// владельцы её отпустили, и передаёт её через мьютекс, поэтому писатель не начнёт менять
+// версию, которую кто-то ещё читает. Ненужные версии удалитель тоже только передаёт, а удаляет
+// их писатель в Publish, так что читатель, отпустивший последнюю ссылку, не платит за удаление индекса.
+// Версии, отпущенные после уничтожения сервера, удаляет последний владелец корзины
+class VersionedSearchServer {
+public:
+    explicit VersionedSearchServer(SearchServer search_server);
+
+    // Снимок остаётся целым и неизменным, пока на него есть ссылка,
+    // в том числе слова, которые вернул его MatchDocument
+    std::shared_ptr<const SearchServer> GetSnapshot() const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                      SearchOptions options = {}) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, SearchOptions options = {}) const;
+
+    // Изменения видны читателям только после Publish. Писатели упорядочиваются между собой мьютексом
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                     const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    void RemoveDuplicates();
+
+    // Делает все изменения видимыми читателям
+    void Publish();
+
+    // Номер опубликованной версии, растёт на единицу при каждой публикации с изменениями
+    uint64_t GetVersion() const;
+
+private:
+    struct Mutation {
+        bool is_removal = false;
+        int document_id = 0;
+        std::string text;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        std::vector<int> ratings;
+
+        static Mutation Addition(int document_id, std::string_view text, DocumentStatus status,
+                                 const std::vector<int>& ratings);
+
+        static Mutation Removal(int document_id);
+    };
+
+    // Сюда удалитель опубликованной версии кладёт её, когда последний читатель её отпустил.
+    // Корзина живёт, пока жив сервер или хотя бы один снимок, поэтому удалитель держит её через shared_ptr
+    struct RecycleBin {
+        std::mutex mutex;
+        // сохранять стоит только опубликованную сейчас версию: следующая публикация сделает её резервной
+        uint64_t awaited_version = 0;
+        std::unique_ptr<SearchServer> server;
+        // отпущенные версии, которые не ждут; их удалит писатель
+        std::vector<std::unique_ptr<SearchServer>> garbage;
+
+        // Сохраняет отпущенную версию как резервную, если её ждут, иначе откладывает на удаление.
+        // Только перекладывает указатель под мьютексом
+        void Put(std::unique_ptr<SearchServer> released_server, uint64_t released_version);
+
+        // Забирает ожидаемую версию, если её уже отпустили, иначе возвращает nullptr,
+        // а отложенные на удаление версии переносит в released_garbage.
+        // Дальше корзина ждёт версию next_awaited_version
+        std::unique_ptr<SearchServer> Take(uint64_t next_awaited_version,
+                                           std::vector<std::unique_ptr<SearchServer>>& released_garbage);
+    };
+
+    std::mutex writer_mutex_;
+    std::shared_ptr<RecycleBin> recycle_bin_ = std::make_shared<RecycleBin>();
+    // читается и заменяется только через std::atomic_load и std::atomic_store
+    std::shared_ptr<const SearchServer> published_;
+    std::unique_ptr<SearchServer> standby_;
+    // изменения, уже внесённые в standby_, но не в опубликованную версию
+    std::vector<Mutation> pending_;
+    std::atomic<uint64_t> version_ = 0;
+
+    // Передаёт server читателям как версию version; отпущенная всеми, она вернётся в recycle_bin_
+    std::shared_ptr<const SearchServer> Share(std::unique_ptr<SearchServer> server, uint64_t version) const;
+};